@@ -1012,6 +1012,10 @@ call <SID>BinOptionG("wa", &wa)
 call append("$", "autoread\tautomatically read a file when it was modified outside of Vim")
 call append("$", "\t(global or local to buffer)")
 call <SID>BinOptionG("ar", &ar)
+if has("filewatch")
+  call append("$", "filewatch\tuse inotify to find out which files were changed outside of Vim")
+  call <SID>BinOptionG("fw", &fw)
+endif
 call append("$", "patchmode\tkeep oldest version of a file; specifies file name extension")
 call <SID>OptionG("pm", &pm)
 call append("$", "fsync\tforcibly sync the file to disk after writing it")
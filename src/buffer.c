@@ -804,9 +804,15 @@ buf_freeall(buf_T *buf, int flags)
 
 #ifdef FEAT_TCL
     tcl_buffer_free(buf);
+#endif
+#ifdef FEAT_SYN_CACHE
+    syn_cache_write(buf);	    /* save syntax states for next time */
 #endif
     ml_close(buf, TRUE);	    /* close and delete the memline/memfile */
     buf->b_ml.ml_line_count = 0;    /* no lines in buffer */
+#ifdef FEAT_FILEWATCH
+    mch_watch_forget(buf);	    /* not checked while unloaded */
+#endif
     if ((flags & BFA_KEEP_UNDO) == 0)
     {
 	u_blockfree(buf);	    /* free the memory allocated for undo */
@@ -814,6 +820,9 @@ buf_freeall(buf_T *buf, int flags)
     }
 #ifdef FEAT_SYN_HL
     syntax_clear(&buf->b_s);	    /* reset syntax info */
+#endif
+#ifdef FEAT_SEARCH_EXTRA
+    search_index_free(buf);	    /* forget about search matches */
 #endif
     buf->b_flags &= ~BF_READERR;    /* a read error is no longer relevant */
 }
@@ -3135,6 +3144,9 @@ setfname(
 	buf->b_sfname = sfname;
     }
     buf->b_fname = buf->b_sfname;
+#ifdef FEAT_FILEWATCH
+    mch_watch_forget(buf);	    /* was watching the old file */
+#endif
 #ifdef UNIX
     if (st.st_dev == (dev_T)-1)
 	buf->b_dev_valid = FALSE;
@@ -1134,6 +1134,38 @@ f_and(typval_T *argvars, typval_T *rettv)
 					& get_tv_number_chk(&argvars[1], NULL);
 }
 
+/*
+ * Append the items of list "l" after line "lnum" in one go, when they are all
+ * strings.  Returns the number of lines appended, zero when not done.
+ */
+    static long
+append_string_list(linenr_T lnum, list_T *l)
+{
+    listitem_T	*li;
+    char_u	**lines;
+    long	count = 0;
+    long	added;
+
+    for (li = l->lv_first; li != NULL; li = li->li_next)
+    {
+	if (li->li_tv.v_type != VAR_STRING)
+	    return 0;
+	++count;
+    }
+    if (count < 2)
+	return 0;
+    lines = (char_u **)lalloc((long_u)(count * sizeof(char_u *)), FALSE);
+    if (lines == NULL)
+	return 0;
+    count = 0;
+    for (li = l->lv_first; li != NULL; li = li->li_next)
+	lines[count++] = li->li_tv.vval.v_string == NULL
+				    ? (char_u *)"" : li->li_tv.vval.v_string;
+    added = ml_append_lines(lnum, lines, count);
+    vim_free(lines);
+    return added;
+}
+
 /*
  * "append(lnum, string/list)" function
  */
@@ -1166,6 +1198,14 @@ f_append(typval_T *argvars, typval_T *rettv)
 	    if (l == NULL)
 		return;
 	    li = l->lv_first;
+	    added = append_string_list(lnum, l);
+	    if (added > 0)
+	    {
+		/* Appended the whole list, or failed halfway. */
+		if (added < list_len(l))
+		    rettv->vval.v_number = 1;
+		li = NULL;
+	    }
 	}
 	for (;;)
 	{
@@ -5570,6 +5610,9 @@ f_has(typval_T *argvars, typval_T *rettv)
 #ifdef FEAT_SEARCHPATH
 	"file_in_path",
 #endif
+#ifdef FEAT_FILEWATCH
+	"filewatch",
+#endif
 #ifdef FEAT_FILTERPIPE
 	"filterpipe",
 #endif
@@ -5804,6 +5847,9 @@ f_has(typval_T *argvars, typval_T *rettv)
 #ifdef FEAT_SYN_HL
 	"syntax",
 #endif
+#ifdef FEAT_SYN_CACHE
+	"syntax_cache",
+#endif
 #if defined(USE_SYSTEM) || !defined(UNIX)
 	"system",
 #endif
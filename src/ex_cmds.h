@@ -904,6 +904,9 @@ EX(CMD_menu,		"menu",		ex_menu,
 EX(CMD_menutranslate,	"menutranslate", ex_menutranslate,
 			EXTRA|TRLBAR|NOTRLCOM|USECTRLV|CMDWIN,
 			ADDR_LINES),
+EX(CMD_memstats,	"memstats",	ex_memstats,
+			EXTRA|TRLBAR|CMDWIN,
+			ADDR_LINES),
 EX(CMD_messages,	"messages",	ex_messages,
 			EXTRA|TRLBAR|RANGE|CMDWIN,
 			ADDR_OTHER),
@@ -1156,12 +1159,21 @@ EX(CMD_redir,		"redir",	ex_redir,
 EX(CMD_redraw,		"redraw",	ex_redraw,
 			BANG|TRLBAR|CMDWIN,
 			ADDR_LINES),
+EX(CMD_redrawprofile,	"redrawprofile", ex_redrawprofile,
+			EXTRA|NEEDARG|TRLBAR|CMDWIN,
+			ADDR_LINES),
 EX(CMD_redrawstatus,	"redrawstatus",	ex_redrawstatus,
 			BANG|TRLBAR|CMDWIN,
 			ADDR_LINES),
 EX(CMD_registers,	"registers",	ex_display,
 			EXTRA|NOTRLCOM|TRLBAR|CMDWIN,
 			ADDR_LINES),
+EX(CMD_regexpcache,	"regexpcache",	ex_regexpcache,
+			EXTRA|TRLBAR|CMDWIN,
+			ADDR_LINES),
+EX(CMD_regexpstats,	"regexpstats",	ex_regexpstats,
+			EXTRA|TRLBAR|CMDWIN,
+			ADDR_LINES),
 EX(CMD_resize,		"resize",	ex_resize,
 			RANGE|NOTADR|TRLBAR|WORD1,
 			ADDR_LINES),
@@ -254,6 +254,12 @@ static void	ex_popup(exarg_T *eap);
 #if !defined(FEAT_SYN_HL) || !defined(FEAT_PROFILE)
 # define ex_syntime		ex_ni
 #endif
+#ifndef FEAT_PROFILE
+# define ex_redrawprofile	ex_ni
+#endif
+#if !defined(FEAT_PROFILE) || !defined(FEAT_FLOAT)
+# define ex_regexpstats		ex_ni
+#endif
 #ifndef FEAT_SPELL
 # define ex_spell		ex_ni
 # define ex_mkspell		ex_ni
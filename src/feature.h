@@ -494,6 +494,14 @@
 # define FEAT_WILDMENU
 #endif
 
+/*
+ * +filewatch		'filewatch' option: use inotify to find out which
+ *			files changed, instead of checking every buffer.
+ */
+#if defined(FEAT_NORMAL) && defined(UNIX) && defined(HAVE_SYS_INOTIFY_H)
+# define FEAT_FILEWATCH
+#endif
+
 /*
  * +viminfo		reading/writing the viminfo file. Takes about 8Kbyte
  *			of code.
@@ -1351,6 +1359,14 @@
 # define FEAT_PERSISTENT_UNDO
 #endif
 
+/*
+ * +syntax_cache	'syncachedir' option: save syntax states for a file, to
+ *			use them when editing it again.
+ */
+#if defined(FEAT_SYN_HL) && defined(FEAT_PERSISTENT_UNDO)
+# define FEAT_SYN_CACHE
+#endif
+
 /*
  * +filterpipe
  */
@@ -22,8 +22,15 @@
 #endif
 
 #define BUFSIZE		8192	/* size of normal write buffer */
+#define WRITEBUFSIZE	0x40000L /* size of buffer for writing a file */
 #define SMBUFSIZE	256	/* size of emergency write buffer */
 
+/* readfile() starts reading with READ_SIZE_MIN bytes and doubles the amount
+ * each time a read fills the whole buffer, up to READ_SIZE_MAX.  Big files
+ * then take far fewer read() calls and buffer allocations. */
+#define READ_SIZE_MIN	0x10000L
+#define READ_SIZE_MAX	0x100000L
+
 /* Is there any system that doesn't have access()? */
 #define USE_MCH_ACCESS
 
@@ -119,6 +126,7 @@ static int  buf_write_bytes(struct bw_info *ip);
 
 #ifdef FEAT_MBYTE
 static linenr_T readfile_linenr(linenr_T linecnt, char_u *p, char_u *endp);
+static char_u *skip_ascii(char_u *p, char_u *end);
 static int ucs2bytes(unsigned c, char_u **pp, int flags);
 static int need_conversion(char_u *fenc);
 static int get_fio_flags(char_u *ptr);
@@ -238,11 +246,15 @@ readfile(
     char_u	*ptr = NULL;		/* pointer into read buffer */
     char_u	*buffer = NULL;		/* read buffer */
     char_u	*new_buffer = NULL;	/* init to shut up gcc */
+    long_u	buffer_size = 0;	/* allocated size of "buffer" or 0 */
     char_u	*line_start = NULL;	/* init to shut up gcc */
     int		wasempty;		/* buffer was empty before reading */
     colnr_T	len;
     long	size = 0;
+    long	read_size = READ_SIZE_MIN;  /* nr of bytes to read at once */
+    long	read_request;
     char_u	*p;
+    char_u	*nul_ptr;
     off_T	filesize = 0;
     int		skip_read = FALSE;
 #ifdef FEAT_CRYPT
@@ -1206,28 +1218,41 @@ retry:
 # if defined(SSIZE_MAX) && (SSIZE_MAX < 0x10000L)
 		size = SSIZE_MAX;		    /* use max I/O size, 52K */
 # else
-		size = 0x10000L;		    /* use buffer >= 64K */
+		size = read_size;		    /* use buffer >= 64K */
 # endif
 #else
 		size = 0x7ff0L - linerest;	    /* limit buffer to 32K */
 #endif
 
-		for ( ; size >= 10; size = (long)((long_u)size >> 1))
+		if (buffer != NULL
+			       && buffer_size >= (long_u)(size + linerest + 1))
 		{
-		    if ((new_buffer = lalloc((long_u)(size + linerest + 1),
-							      FALSE)) != NULL)
-			break;
+		    /* The previous buffer is big enough, move the remaining
+		     * characters to the start instead of allocating again. */
+		    if (linerest)
+			mch_memmove(buffer, ptr - linerest, (size_t)linerest);
 		}
-		if (new_buffer == NULL)
+		else
 		{
-		    do_outofmem_msg((long_u)(size * 2 + linerest + 1));
-		    error = TRUE;
-		    break;
+		    for ( ; size >= 10; size = (long)((long_u)size >> 1))
+		    {
+			if ((new_buffer = lalloc((long_u)(size + linerest + 1),
+							      FALSE)) != NULL)
+			    break;
+		    }
+		    if (new_buffer == NULL)
+		    {
+			do_outofmem_msg((long_u)(size * 2 + linerest + 1));
+			error = TRUE;
+			break;
+		    }
+		    if (linerest)   /* copy characters from the previous buffer */
+			mch_memmove(new_buffer, ptr - linerest,
+							   (size_t)linerest);
+		    vim_free(buffer);
+		    buffer = new_buffer;
+		    buffer_size = (long_u)(size + linerest + 1);
 		}
-		if (linerest)	/* copy characters from the previous buffer */
-		    mch_memmove(new_buffer, ptr - linerest, (size_t)linerest);
-		vim_free(buffer);
-		buffer = new_buffer;
 		ptr = buffer + linerest;
 		line_start = buffer;
 
@@ -1339,9 +1364,13 @@ retry:
 		else
 		{
 		    /*
-		     * Read bytes from the file.
+		     * Read bytes from the file.  When the read filled the whole
+		     * buffer the file is probably big, read more next time.
 		     */
+		    read_request = size;
 		    size = read_eintr(fd, ptr, size);
+		    if (size == read_request && read_size < READ_SIZE_MAX)
+			read_size *= 2;
 		}
 
 #ifdef FEAT_CRYPT
@@ -1405,6 +1434,7 @@ retry:
 			{
 			    vim_free(buffer);
 			    buffer = new_buffer;
+			    buffer_size = 0;	/* size unknown, don't reuse */
 			    new_buffer = NULL;
 			    line_start = buffer;
 			    ptr = buffer + linerest;
@@ -1875,7 +1905,18 @@ retry:
 		while (p > ptr)
 		{
 		    if (fio_flags & FIO_LATIN1)
+		    {
+			if (enc_utf8 && p[-1] < 0x80)
+			{
+			    /* Copy a run of ASCII characters, they are the
+			     * same in UTF-8. */
+			    do
+				*--dest = *--p;
+			    while (p > ptr && p[-1] < 0x80);
+			    continue;
+			}
 			u8c = *--p;
+		    }
 		    else if (fio_flags & (FIO_UCS2 | FIO_UTF16))
 		    {
 			if (fio_flags & FIO_ENDIAN_L)
@@ -1982,8 +2023,13 @@ retry:
 		    }
 		    if (enc_utf8)	/* produce UTF-8 */
 		    {
-			dest -= utf_char2len(u8c);
-			(void)utf_char2bytes(u8c, dest);
+			if (u8c < 0x80)
+			    *--dest = u8c;
+			else
+			{
+			    dest -= utf_char2len(u8c);
+			    (void)utf_char2bytes(u8c, dest);
+			}
 		    }
 		    else		/* produce Latin1 */
 		    {
@@ -2024,9 +2070,11 @@ retry:
 		/* Reading UTF-8: Check if the bytes are valid UTF-8. */
 		for (p = ptr; ; ++p)
 		{
-		    int	 todo = (int)((ptr + size) - p);
+		    int	 todo;
 		    int	 l;
 
+		    p = skip_ascii(p, ptr + size);
+		    todo = (int)((ptr + size) - p);
 		    if (todo <= 0)
 			break;
 		    if (*p >= 0x80)
@@ -2222,71 +2270,82 @@ rewind_retry:
 	}
 	else
 	{
-	    --ptr;
-	    while (++ptr, --size >= 0)
+	    /* Use memchr() to find the next NL and NUL, it is much faster than
+	     * checking every byte.  "nul_ptr" is the next NUL to be replaced,
+	     * NULL when there are no more NULs. */
+	    nul_ptr = (char_u *)memchr(ptr, NUL, (size_t)size);
+	    while (size > 0)
 	    {
-		if ((c = *ptr) != NUL && c != NL)  /* catch most common case */
-		    continue;
-		if (c == NUL)
-		    *ptr = NL;	/* NULs are replaced by newlines! */
-		else
+		p = (char_u *)memchr(ptr, NL, (size_t)size);
+		if (p == NULL)
+		    p = ptr + size;
+		while (nul_ptr != NULL && nul_ptr < p)
 		{
-		    if (skip_count == 0)
+		    *nul_ptr = NL;	/* NULs are replaced by newlines! */
+		    nul_ptr = (char_u *)memchr(nul_ptr + 1, NUL,
+						 (size_t)(ptr + size - nul_ptr - 1));
+		}
+		size -= (long)(p - ptr);
+		ptr = p;
+		if (size <= 0)
+		    break;
+		--size;
+		if (skip_count == 0)
+		{
+		    *ptr = NUL;		/* end of line */
+		    len = (colnr_T)(ptr - line_start + 1);
+		    if (fileformat == EOL_DOS)
 		    {
-			*ptr = NUL;		/* end of line */
-			len = (colnr_T)(ptr - line_start + 1);
-			if (fileformat == EOL_DOS)
+			if (ptr[-1] == CAR)	/* remove CR */
 			{
-			    if (ptr[-1] == CAR)	/* remove CR */
-			    {
-				ptr[-1] = NUL;
-				--len;
-			    }
-			    /*
-			     * Reading in Dos format, but no CR-LF found!
-			     * When 'fileformats' includes "unix", delete all
-			     * the lines read so far and start all over again.
-			     * Otherwise give an error message later.
-			     */
-			    else if (ff_error != EOL_DOS)
-			    {
-				if (   try_unix
-				    && !read_stdin
-				    && (read_buffer
-					|| vim_lseek(fd, (off_T)0L, SEEK_SET)
-									  == 0))
-				{
-				    fileformat = EOL_UNIX;
-				    if (set_options)
-					set_fileformat(EOL_UNIX, OPT_LOCAL);
-				    file_rewind = TRUE;
-				    keep_fileformat = TRUE;
-				    goto retry;
-				}
-				ff_error = EOL_DOS;
-			    }
+			    ptr[-1] = NUL;
+			    --len;
 			}
-			if (ml_append(lnum, line_start, len, newfile) == FAIL)
+			/*
+			 * Reading in Dos format, but no CR-LF found!
+			 * When 'fileformats' includes "unix", delete all
+			 * the lines read so far and start all over again.
+			 * Otherwise give an error message later.
+			 */
+			else if (ff_error != EOL_DOS)
 			{
-			    error = TRUE;
-			    break;
+			    if (   try_unix
+				&& !read_stdin
+				&& (read_buffer
+				    || vim_lseek(fd, (off_T)0L, SEEK_SET)
+								      == 0))
+			    {
+				fileformat = EOL_UNIX;
+				if (set_options)
+				    set_fileformat(EOL_UNIX, OPT_LOCAL);
+				file_rewind = TRUE;
+				keep_fileformat = TRUE;
+				goto retry;
+			    }
+			    ff_error = EOL_DOS;
 			}
+		    }
+		    if (ml_append(lnum, line_start, len, newfile) == FAIL)
+		    {
+			error = TRUE;
+			break;
+		    }
 #ifdef FEAT_PERSISTENT_UNDO
-			if (read_undo_file)
-			    sha256_update(&sha_ctx, line_start, len);
+		    if (read_undo_file)
+			sha256_update(&sha_ctx, line_start, len);
 #endif
-			++lnum;
-			if (--read_count == 0)
-			{
-			    error = TRUE;	    /* break loop */
-			    line_start = ptr;	/* nothing left to write */
-			    break;
-			}
+		    ++lnum;
+		    if (--read_count == 0)
+		    {
+			error = TRUE;	    /* break loop */
+			line_start = ptr;	/* nothing left to write */
+			break;
 		    }
-		    else
-			--skip_count;
-		    line_start = ptr + 1;
 		}
+		else
+		    --skip_count;
+		line_start = ptr + 1;
+		++ptr;
 	    }
 	}
 	linerest = (long)(ptr - line_start);
@@ -2754,6 +2813,28 @@ readfile_linenr(
 	    ++lnum;
     return lnum;
 }
+
+/*
+ * Return a pointer to the first byte from "p" up to "end" that is not ASCII,
+ * or "end" when there is none.  Checks a word at a time, text is mostly ASCII.
+ */
+    static char_u *
+skip_ascii(char_u *p, char_u *end)
+{
+    long_u	word;
+    long_u	high_bits = ~(long_u)0 / 0xff * 0x80;
+
+    while (end - p >= (long)sizeof(long_u))
+    {
+	mch_memmove(&word, p, sizeof(long_u));
+	if (word & high_bits)
+	    break;
+	p += sizeof(long_u);
+    }
+    while (p < end && *p < 0x80)
+	++p;
+    return p;
+}
 #endif
 
 /*
@@ -3128,8 +3209,11 @@ buf_write(
     char_u	    *wfname = NULL;	/* name of file to write to */
     char_u	    *s;
     char_u	    *ptr;
+    char_u	    *p;
     char_u	    c;
     int		    len;
+    long	    linelen;
+    long	    n;
     linenr_T	    lnum;
     long	    nchars;
     char_u	    *errmsg = NULL;
@@ -3152,6 +3236,9 @@ buf_write(
     static char	    *err_readonly = "is read-only (cannot override: \"W\" in 'cpoptions')";
 #if defined(UNIX)			    /*XXX fix me sometime? */
     int		    made_writable = FALSE;  /* 'w' bit has been set */
+#endif
+#ifdef FEAT_RELTIME
+    proftime_T	    write_time;		    /* time used for writing */
 #endif
 					/* writing everything */
     int		    whole = (start == 1 && end == buf->b_ml.ml_line_count);
@@ -3517,16 +3604,24 @@ buf_write(
 		    (char_u *)"", 0);	/* show that we are busy */
     msg_scroll = FALSE;		    /* always overwrite the file message now */
 
-    buffer = alloc(BUFSIZE);
-    if (buffer == NULL)		    /* can't allocate big buffer, use small
+    /* Use a big buffer to reduce the number of write() calls.  When that
+     * fails try a normal one. */
+    buffer = lalloc(WRITEBUFSIZE, FALSE);
+    if (buffer != NULL)
+	bufsize = WRITEBUFSIZE;
+    else
+    {
+	buffer = alloc(BUFSIZE);
+	if (buffer == NULL)	    /* can't allocate big buffer, use small
 				     * one (to be able to write when out of
 				     * memory) */
-    {
-	buffer = smallbuf;
-	bufsize = SMBUFSIZE;
+	{
+	    buffer = smallbuf;
+	    bufsize = SMBUFSIZE;
+	}
+	else
+	    bufsize = BUFSIZE;
     }
-    else
-	bufsize = BUFSIZE;
 
     /*
      * Get information about original file (if there is one).
@@ -4515,31 +4610,46 @@ restore_backup:
     write_info.bw_len = bufsize;
 #ifdef HAS_BW_FLAGS
     write_info.bw_flags = wb_flags;
+#endif
+#ifdef FEAT_RELTIME
+    if (p_verbose > 0)
+	profile_start(&write_time);
 #endif
     fileformat = get_fileformat_force(buf, eap);
     s = buffer;
     len = 0;
     for (lnum = start; lnum <= end; ++lnum)
     {
-	/*
-	 * The next while loop is done once for each character written.
-	 * Keep it fast!
-	 */
-	ptr = ml_get_buf(buf, lnum, FALSE) - 1;
+	ptr = ml_get_buf(buf, lnum, FALSE);
+	linelen = (long)STRLEN(ptr);
 #ifdef FEAT_PERSISTENT_UNDO
 	if (write_undo_file)
-	    sha256_update(&sha_ctx, ptr + 1, (UINT32_T)(STRLEN(ptr + 1) + 1));
+	    sha256_update(&sha_ctx, ptr, (UINT32_T)(linelen + 1));
 #endif
-	while ((c = *++ptr) != NUL)
-	{
-	    if (c == NL)
-		*s = NUL;		/* replace newlines with NULs */
-	    else if (c == CAR && fileformat == EOL_MAC)
-		*s = NL;		/* Mac: replace CRs with NLs */
-	    else
-		*s = c;
-	    ++s;
-	    if (++len != bufsize)
+	/*
+	 * The next while loop is done once for each piece of the line that
+	 * fits in the buffer.  Keep it fast!
+	 */
+	while (linelen > 0)
+	{
+	    n = bufsize - len;
+	    if (n > linelen)
+		n = linelen;
+	    mch_memmove(s, ptr, (size_t)n);
+
+	    /* Replace newlines with NULs. */
+	    for (p = s; (p = memchr(p, NL, (size_t)(s + n - p))) != NULL; )
+		*p++ = NUL;
+	    /* Mac: replace CRs with NLs. */
+	    if (fileformat == EOL_MAC)
+		for (p = s; (p = memchr(p, CAR, (size_t)(s + n - p))) != NULL; )
+		    *p++ = NL;
+
+	    ptr += n;
+	    linelen -= n;
+	    s += n;
+	    len += n;
+	    if (len != bufsize)
 		continue;
 	    if (buf_write_bytes(&write_info) == FAIL)
 	    {
@@ -4894,6 +5004,16 @@ restore_backup:
 
 	set_keep_msg(msg_trunc_attr(IObuff, FALSE, 0), 0);
     }
+#ifdef FEAT_RELTIME
+    if (p_verbose > 0)
+    {
+	profile_end(&write_time);
+	verbose_enter();
+	smsg((char_u *)_("Wrote %ld bytes to \"%s\" in %s seconds"), nchars,
+		    fname, skipwhite((char_u *)profile_msg(&write_time)));
+	verbose_leave();
+    }
+#endif
 
     /* When written everything correctly: reset 'modified'.  Unless not
      * writing to the original file and '+' is not in 'cpoptions'. */
@@ -6816,6 +6936,9 @@ buf_check_timestamp(
 
     if (       !(buf->b_flags & BF_NOTEDITED)
 	    && buf->b_mtime != 0
+#ifdef FEAT_FILEWATCH
+	    && mch_watch_check(buf)
+#endif
 	    && ((stat_res = mch_stat((char *)buf->b_ffname, &st)) < 0
 		|| time_differs((long)st.st_mtime, buf->b_mtime)
 		|| st.st_size != buf->b_orig_size
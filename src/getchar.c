@@ -1526,6 +1526,28 @@ before_blocking(void)
     if (may_garbage_collect)
 	garbage_collect(FALSE);
 #endif
+#ifdef FEAT_SYN_HL
+    /* Use the time until a key is typed to parse syntax ahead, a little bit
+     * at a time, so that it does not have to be done when jumping around. */
+    if (!exiting)
+    {
+	int	change_cnt = typebuf.tb_change_cnt;
+
+	while (!ui_char_avail() && syn_parse_idle())
+	{
+# ifdef FEAT_TIMERS
+	    /* Timers and messages must not wait for the parsing. */
+	    (void)check_due_timer();
+# endif
+# ifdef MESSAGE_QUEUE
+	    parse_queued_messages();
+# endif
+	    if (typebuf.tb_change_cnt != change_cnt)
+		/* a callback may have used feedkeys() */
+		break;
+	}
+    }
+#endif
 }
 
 /*
@@ -457,6 +457,13 @@ EXTERN int	sys_menu INIT(= FALSE);
  * ('lines' and 'rows') must not be changed. */
 EXTERN int	updating_screen INIT(= FALSE);
 
+#ifdef FEAT_PROFILE
+/* Set while measuring a screen update for ":redrawprofile". */
+EXTERN int	redraw_prof_active INIT(= FALSE);
+/* Set after a measured screen update until its output is flushed. */
+EXTERN int	redraw_prof_flush INIT(= FALSE);
+#endif
+
 #ifdef FEAT_GUI
 # ifdef FEAT_MENU
 /* Menu item just selected, set by check_termcode() */
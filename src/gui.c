@@ -2956,9 +2956,14 @@ gui_wait_for_chars(long wtime)
 
     if (retval == FAIL)
     {
+	int	tb_change_cnt = typebuf.tb_change_cnt;
+
 	/* Blocking wait. */
 	before_blocking();
-	retval = gui_wait_for_chars_or_timer(-1L);
+	/* Not when a callback invoked while parsing syntax ahead used
+	 * feedkeys(). */
+	if (typebuf.tb_change_cnt == tb_change_cnt)
+	    retval = gui_wait_for_chars_or_timer(-1L);
     }
 
     gui_mch_stop_blink();
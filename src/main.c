@@ -1423,6 +1423,17 @@ getout(int exitval)
 	write_viminfo(NULL, FALSE);
 #endif
 
+#ifdef FEAT_SYN_CACHE
+    if (*p_scdir != NUL)
+    {
+	buf_T	*sbuf;
+
+	/* Save the syntax states of loaded buffers in 'syncachedir'. */
+	FOR_ALL_BUFFERS(sbuf)
+	    syn_cache_write(sbuf);
+    }
+#endif
+
 #ifdef FEAT_AUTOCMD
     if (get_vim_var_nr(VV_DYING) <= 1)
 	apply_autocmds(EVENT_VIMLEAVE, NULL, NULL, FALSE, curbuf);
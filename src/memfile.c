@@ -66,6 +66,8 @@ extern int dos2;			/* this is in os_amiga.c */
 #endif
 
 #define MEMFILE_PAGE_SIZE 4096		/* default page size */
+#define MF_SYNC_RUN_MAX	0x40000L	/* max bytes written at once by
+					   mf_sync() */
 
 static long_u	total_mem_used = 0;	/* total memory used for memfiles */
 
@@ -82,6 +84,7 @@ static bhdr_T *mf_rem_free(memfile_T *);
 static int  mf_read(memfile_T *, bhdr_T *);
 static int  mf_write(memfile_T *, bhdr_T *);
 static int  mf_write_block(memfile_T *mfp, bhdr_T *hp, off_T offset, unsigned size);
+static int  mf_write_run(memfile_T *mfp, bhdr_T **list, int count, char_u *buf);
 static int  mf_trans_add(memfile_T *, bhdr_T *);
 static void mf_do_open(memfile_T *, char_u *, int);
 static void mf_hash_init(mf_hashtab_T *);
@@ -91,6 +94,14 @@ static mf_hashitem_T *mf_hash_find(mf_hashtab_T *, blocknr_T);
 static void mf_hash_add_item(mf_hashtab_T *, mf_hashitem_T *);
 static void mf_hash_rem_item(mf_hashtab_T *, mf_hashitem_T *);
 static int mf_hash_grow(mf_hashtab_T *);
+static void mf_set_used_count_max(memfile_T *);
+static int mf_sync_stop(int flags);
+static int
+#ifdef __BORLANDC__
+    _RTLENTRYF
+#endif
+	mf_bnum_compare(const void *s1, const void *s2);
+static int mf_sync_sorted(memfile_T *mfp, int flags, int *all_done);
 
 /*
  * The functions for using a memfile:
@@ -156,6 +167,7 @@ mf_open(char_u *fname, int flags)
     mfp->mf_used_last = NULL;
     mfp->mf_dirty = FALSE;
     mfp->mf_used_count = 0;
+    mf_clear_stats(mfp);
     mf_hash_init(&mfp->mf_hash);
     mf_hash_init(&mfp->mf_trans);
     mfp->mf_page_size = MEMFILE_PAGE_SIZE;
@@ -187,27 +199,30 @@ mf_open(char_u *fname, int flags)
     mfp->mf_blocknr_min = -1;
     mfp->mf_neg_count = 0;
     mfp->mf_infile_count = mfp->mf_blocknr_max;
+    mf_set_used_count_max(mfp);
 
-    /*
-     * Compute maximum number of pages ('maxmem' is in Kbyte):
-     *	'mammem' * 1Kbyte / page-size-in-bytes.
-     * Avoid overflow by first reducing page size as much as possible.
-     */
-    {
-	int	    shift = 10;
-	unsigned    page_size = mfp->mf_page_size;
+    return mfp;
+}
 
-	while (shift > 0 && (page_size & 1) == 0)
-	{
-	    page_size = page_size >> 1;
-	    --shift;
-	}
-	mfp->mf_used_count_max = (p_mm << shift) / page_size;
-	if (mfp->mf_used_count_max < 10)
-	    mfp->mf_used_count_max = 10;
-    }
+/*
+ * Compute maximum number of pages ('maxmem' is in Kbyte):
+ *	'mammem' * 1Kbyte / page-size-in-bytes.
+ * Avoid overflow by first reducing page size as much as possible.
+ */
+    static void
+mf_set_used_count_max(memfile_T *mfp)
+{
+    int		shift = 10;
+    unsigned	page_size = mfp->mf_page_size;
 
-    return mfp;
+    while (shift > 0 && (page_size & 1) == 0)
+    {
+	page_size = page_size >> 1;
+	--shift;
+    }
+    mfp->mf_used_count_max = (p_mm << shift) / page_size;
+    if (mfp->mf_used_count_max < 10)
+	mfp->mf_used_count_max = 10;
 }
 
 /*
@@ -306,15 +321,31 @@ mf_close_file(
 
 /*
  * Set new size for a memfile.  Used when block 0 of a swapfile has been read
- * and the size it indicates differs from what was guessed.
+ * and the size it indicates differs from what was guessed, and for a new
+ * memfile that is going to hold a big file.
  */
     void
 mf_new_page_size(memfile_T *mfp, unsigned new_size)
 {
-    /* Correct the memory used for block 0 to the new size, because it will be
-     * freed with that size later on. */
-    total_mem_used += new_size - mfp->mf_page_size;
+    /* Correct the memory used for the blocks in memory (only block 0, if
+     * any) to the new size, because they will be freed with that size later
+     * on. */
+    total_mem_used -= (long_u)mfp->mf_used_count * mfp->mf_page_size;
+    total_mem_used += (long_u)mfp->mf_used_count * new_size;
     mfp->mf_page_size = new_size;
+    mf_set_used_count_max(mfp);
+}
+
+/*
+ * Reset the counters for ":memstats".
+ */
+    void
+mf_clear_stats(memfile_T *mfp)
+{
+    mfp->mf_hit_count = 0;
+    mfp->mf_miss_count = 0;
+    mfp->mf_write_count = 0;
+    mfp->mf_release_count = 0;
 }
 
 /*
@@ -448,11 +479,14 @@ mf_get(memfile_T *mfp, blocknr_T nr, int page_count)
 	    mf_free_bhdr(hp);
 	    return NULL;
 	}
+	++mfp->mf_miss_count;
     }
     else
     {
 	mf_rem_used(mfp, hp);	/* remove from list, insert in front below */
 	mf_rem_hash(mfp, hp);
+	hp->bh_flags |= BH_REFERENCED;
+	++mfp->mf_hit_count;
     }
 
     hp->bh_flags |= BH_LOCKED;
@@ -541,6 +575,7 @@ mf_sync(memfile_T *mfp, int flags)
 {
     int		status;
     bhdr_T	*hp;
+    int		all_done;
 #if defined(SYNC_DUP_CLOSE)
     int		fd;
 #endif
@@ -557,43 +592,46 @@ mf_sync(memfile_T *mfp, int flags)
     got_int = FALSE;
 
     /*
-     * sync from last to first (may reduce the probability of an inconsistent
-     * file) If a write fails, it is very likely caused by a full filesystem.
-     * Then we only try to write blocks within the existing file. If that also
-     * fails then we give up.
+     * First try writing the blocks sorted on block number, that allows for
+     * writing a sequence of blocks with one system call.
      */
-    status = OK;
-    for (hp = mfp->mf_used_last; hp != NULL; hp = hp->bh_prev)
-	if (((flags & MFS_ALL) || hp->bh_bnum >= 0)
-		&& (hp->bh_flags & BH_DIRTY)
-		&& (status == OK || (hp->bh_bnum >= 0
-		    && hp->bh_bnum < mfp->mf_infile_count)))
-	{
-	    if ((flags & MFS_ZERO) && hp->bh_bnum != 0)
-		continue;
-	    if (mf_write(mfp, hp) == FAIL)
-	    {
-		if (status == FAIL)	/* double error: quit syncing */
-		    break;
-		status = FAIL;
-	    }
-	    if (flags & MFS_STOP)
+    status = NOTDONE;
+    if (!(flags & MFS_ZERO))
+	status = mf_sync_sorted(mfp, flags, &all_done);
+    if (status == NOTDONE)
+    {
+	/*
+	 * sync from last to first (may reduce the probability of an
+	 * inconsistent file) If a write fails, it is very likely caused by a
+	 * full filesystem. Then we only try to write blocks within the
+	 * existing file. If that also fails then we give up.
+	 */
+	status = OK;
+	for (hp = mfp->mf_used_last; hp != NULL; hp = hp->bh_prev)
+	    if (((flags & MFS_ALL) || hp->bh_bnum >= 0)
+		    && (hp->bh_flags & BH_DIRTY)
+		    && (status == OK || (hp->bh_bnum >= 0
+			&& hp->bh_bnum < mfp->mf_infile_count)))
 	    {
-		/* Stop when char available now. */
-		if (ui_char_avail())
+		if ((flags & MFS_ZERO) && hp->bh_bnum != 0)
+		    continue;
+		if (mf_write(mfp, hp) == FAIL)
+		{
+		    if (status == FAIL)	/* double error: quit syncing */
+			break;
+		    status = FAIL;
+		}
+		if (mf_sync_stop(flags))
 		    break;
 	    }
-	    else
-		ui_breakcheck();
-	    if (got_int)
-		break;
-	}
+	all_done = (hp == NULL);
+    }
 
     /*
      * If the whole list is flushed, the memfile is not dirty anymore.
      * In case of an error this flag is also set, to avoid trying all the time.
      */
-    if (hp == NULL || status == FAIL)
+    if (all_done || status == FAIL)
 	mfp->mf_dirty = FALSE;
 
     if ((flags & MFS_FLUSH) && *p_sws != NUL)
@@ -684,6 +722,129 @@ mf_sync(memfile_T *mfp, int flags)
     return status;
 }
 
+/*
+ * Return TRUE when mf_sync() should stop writing blocks: when "flags" has
+ * MFS_STOP and a character is available or when interrupted.
+ */
+    static int
+mf_sync_stop(int flags)
+{
+    if (flags & MFS_STOP)
+    {
+	/* Stop when char available now. */
+	if (ui_char_avail())
+	    return TRUE;
+    }
+    else
+	ui_breakcheck();
+    return got_int;
+}
+
+/*
+ * Compare function for qsort(): sort blocks on their number.
+ */
+    static int
+#ifdef __BORLANDC__
+_RTLENTRYF
+#endif
+mf_bnum_compare(const void *s1, const void *s2)
+{
+    blocknr_T	n1 = (*(bhdr_T **)s1)->bh_bnum;
+    blocknr_T	n2 = (*(bhdr_T **)s2)->bh_bnum;
+
+    return n1 == n2 ? 0 : n1 > n2 ? 1 : -1;
+}
+
+/*
+ * Write the dirty blocks of "mfp" for mf_sync(), in order of their block
+ * number.  Blocks that follow each other in the swap file are written with
+ * one system call, up to MF_SYNC_RUN_MAX bytes.
+ * "*all_done" is set to TRUE when all blocks were handled.
+ * Return OK, FAIL, or NOTDONE when out of memory, nothing was written then.
+ */
+    static int
+mf_sync_sorted(memfile_T *mfp, int flags, int *all_done)
+{
+    bhdr_T	*hp;
+    bhdr_T	**list;
+    char_u	*run_buf;
+    int		count = 0;
+    int		i;
+    int		n;
+    long	size;
+    int		status = OK;
+
+    *all_done = TRUE;
+    for (hp = mfp->mf_used_last; hp != NULL; hp = hp->bh_prev)
+	if (((flags & MFS_ALL) || hp->bh_bnum >= 0)
+						   && (hp->bh_flags & BH_DIRTY))
+	    ++count;
+    if (count == 0)
+	return OK;
+    list = (bhdr_T **)lalloc((long_u)(count * sizeof(bhdr_T *)), FALSE);
+    if (list == NULL)
+	return NOTDONE;
+    run_buf = lalloc(MF_SYNC_RUN_MAX, FALSE);
+
+    /* Blocks with a negative number get a number in the file first. */
+    n = 0;
+    for (hp = mfp->mf_used_last; hp != NULL; hp = hp->bh_prev)
+	if (((flags & MFS_ALL) || hp->bh_bnum >= 0)
+						   && (hp->bh_flags & BH_DIRTY))
+	{
+	    if (hp->bh_bnum < 0 && mf_trans_add(mfp, hp) == FAIL)
+		status = FAIL;
+	    else
+		list[n++] = hp;
+	}
+    qsort((void *)list, (size_t)n, sizeof(bhdr_T *), mf_bnum_compare);
+
+    /*
+     * If a write fails, it is very likely caused by a full filesystem.  Then
+     * we only try to write blocks within the existing file.  If that also
+     * fails then we give up.
+     */
+    for (i = 0; i < n; i += count)
+    {
+	hp = list[i];
+	count = 1;
+	if (!(hp->bh_flags & BH_DIRTY)	/* written when filling a gap */
+		|| (status == FAIL && hp->bh_bnum >= mfp->mf_infile_count))
+	    continue;
+
+	/* Find the blocks that directly follow this one. */
+	size = (long)mfp->mf_page_size * hp->bh_page_count;
+	if (run_buf != NULL && hp->bh_bnum <= mfp->mf_infile_count)
+	    while (i + count < n
+		    && list[i + count]->bh_bnum == list[i + count - 1]->bh_bnum
+					 + list[i + count - 1]->bh_page_count
+		    && (status != FAIL
+			   || list[i + count]->bh_bnum < mfp->mf_infile_count)
+		    && size + (long)mfp->mf_page_size
+			      * list[i + count]->bh_page_count <= MF_SYNC_RUN_MAX)
+	    {
+		size += (long)mfp->mf_page_size * list[i + count]->bh_page_count;
+		++count;
+	    }
+
+	if ((count == 1 ? mf_write(mfp, hp)
+			: mf_write_run(mfp, list + i, count, run_buf)) == FAIL)
+	{
+	    if (status == FAIL)		/* double error: quit syncing */
+		break;
+	    status = FAIL;
+	}
+	if (mf_sync_stop(flags))
+	    break;
+    }
+    if (i < n)
+	*all_done = FALSE;
+
+    vim_free(run_buf);
+    vim_free(list);
+    return status;
+}
+
 /*
  * For all blocks in memory file *mfp that have a positive block number set
  * the dirty flag.  These are blocks that need to be written to a newly
@@ -775,6 +936,7 @@ mf_rem_used(memfile_T *mfp, bhdr_T *hp)
 mf_release(memfile_T *mfp, int page_count)
 {
     bhdr_T	*hp;
+    bhdr_T	*prevp;
     int		need_release;
     buf_T	*buf;
 
@@ -814,9 +976,28 @@ mf_release(memfile_T *mfp, int page_count)
     if (mfp->mf_fd < 0 || !need_release)
 	return NULL;
 
-    for (hp = mfp->mf_used_last; hp != NULL; hp = hp->bh_prev)
-	if (!(hp->bh_flags & BH_LOCKED))
+    /*
+     * Find the least recently used block that is not locked.  A block that
+     * was used again since it was read gets a second chance: it is moved to
+     * the front of the list.  Since it ends up before the blocks still to
+     * be checked it is found again if nothing else can be released.
+     */
+    for (hp = mfp->mf_used_last; hp != NULL; hp = prevp)
+    {
+	prevp = hp->bh_prev;
+	if (hp->bh_flags & BH_LOCKED)
+	    continue;
+	if (!(hp->bh_flags & BH_REFERENCED))
 	    break;
+	hp->bh_flags &= ~BH_REFERENCED;
+	if (prevp != NULL)
+	{
+	    mf_rem_used(mfp, hp);
+	    mf_ins_used(mfp, hp);
+	}
+	else
+	    break;	/* already at the front */
+    }
     if (hp == NULL)	/* not a single one that can be released */
 	return NULL;
 
@@ -829,6 +1010,7 @@ mf_release(memfile_T *mfp, int page_count)
 
     mf_rem_used(mfp, hp);
     mf_rem_hash(mfp, hp);
+    ++mfp->mf_release_count;
 
     /*
      * If a bhdr_T is returned, make sure that the page_count of bh_data is
@@ -1054,6 +1236,7 @@ mf_write(memfile_T *mfp, bhdr_T *hp)
 	    return FAIL;
 	}
 	did_swapwrite_msg = FALSE;
+	++mfp->mf_write_count;
 	if (hp2 != NULL)		    /* written a non-dummy block */
 	    hp2->bh_flags &= ~BH_DIRTY;
 					    /* appended to the file */
@@ -1101,6 +1284,69 @@ mf_write_block(
     return result;
 }
 
+/*
+ * Write "count" blocks from "list", which follow each other in the file and
+ * are within the file or directly after it, with one system call.  "buf"
+ * must be big enough to hold all of them.
+ * Return FAIL or OK.
+ */
+    static int
+mf_write_run(memfile_T *mfp, bhdr_T **list, int count, char_u *buf)
+{
+    off_T	offset;
+    char_u	*p = buf;
+    char_u	*data;
+    unsigned	size;
+    int		i;
+
+    offset = (off_T)mfp->mf_page_size * list[0]->bh_bnum;
+    for (i = 0; i < count; ++i)
+    {
+	size = mfp->mf_page_size * list[i]->bh_page_count;
+	data = list[i]->bh_data;
+#ifdef FEAT_CRYPT
+	/* Encrypt if 'key' is set and this is a data block. */
+	if (*mfp->mf_buffer->b_p_key != NUL)
+	{
+	    data = ml_encrypt_data(mfp, data, offset + (p - buf), size);
+	    if (data == NULL)
+		return FAIL;
+	}
+#endif
+	mch_memmove(p, data, (size_t)size);
+#ifdef FEAT_CRYPT
+	if (data != list[i]->bh_data)
+	    vim_free(data);
+#endif
+	p += size;
+    }
+
+    if (vim_lseek(mfp->mf_fd, offset, SEEK_SET) != offset)
+    {
+	PERROR(_("E296: Seek error in swap file write"));
+	return FAIL;
+    }
+    size = (unsigned)(p - buf);
+    if ((unsigned)write_eintr(mfp->mf_fd, buf, size) != size)
+    {
+	/* Same as in mf_write(): avoid repeating the error message. */
+	if (!did_swapwrite_msg)
+	    EMSG(_("E297: Write error in swap file"));
+	did_swapwrite_msg = TRUE;
+	return FAIL;
+    }
+    did_swapwrite_msg = FALSE;
+
+    for (i = 0; i < count; ++i)
+	list[i]->bh_flags &= ~BH_DIRTY;
+    mfp->mf_write_count += count;
+    if (list[count - 1]->bh_bnum + (blocknr_T)list[count - 1]->bh_page_count
+						       > mfp->mf_infile_count)
+	mfp->mf_infile_count = list[count - 1]->bh_bnum
+				   + (blocknr_T)list[count - 1]->bh_page_count;
+    return OK;
+}
+
 /*
  * Make block number for *hp positive and add it to the translation list
  *
@@ -248,12 +248,15 @@ static void add_b0_fenc(ZERO_BL *b0p, buf_T *buf);
 static time_t swapfile_info(char_u *);
 static int recov_file_names(char_u **, char_u *, int prepend_dot);
 static int ml_append_int(buf_T *, linenr_T, char_u *, colnr_T, int, int);
+static int ml_append_locked(buf_T *buf, linenr_T lnum, char_u *line, colnr_T len);
 static int ml_delete_int(buf_T *, linenr_T, int);
 static char_u *findswapname(buf_T *, char_u **, char_u *);
 static void ml_flush_line(buf_T *);
 static bhdr_T *ml_new_data(memfile_T *, int, int);
 static bhdr_T *ml_new_ptr(memfile_T *);
 static bhdr_T *ml_find_line(buf_T *, linenr_T, int);
+static bhdr_T *ml_find_cached(buf_T *buf, linenr_T lnum);
+static void ml_add_cached(buf_T *buf, blocknr_T bnum, int page_count, linenr_T low, linenr_T high);
 static int ml_add_stack(buf_T *);
 static void ml_lineadd(buf_T *, int);
 static int b0_magic_wrong(ZERO_BL *);
@@ -272,6 +275,14 @@ static cryptstate_T *ml_crypt_prepare(memfile_T *mfp, off_T offset, int reading)
 static void ml_updatechunk(buf_T *buf, long line, long len, int updtype);
 #endif
 
+/*
+ * For a file that would need more than ML_BIG_BLOCK_COUNT data blocks the page
+ * size is doubled, up to ML_BIG_PAGE_SIZE.  Must not be more than
+ * MAX_SWAP_PAGE_SIZE, otherwise the swap file can't be recovered.
+ */
+#define ML_BIG_BLOCK_COUNT	8192L
+#define ML_BIG_PAGE_SIZE	32768
+
 /*
  * Open a new memline for "buf".
  *
@@ -285,6 +296,8 @@ ml_open(buf_T *buf)
     ZERO_BL	*b0p;
     PTR_BL	*pp;
     DATA_BL	*dp;
+    stat_T	st;
+    unsigned	page_size;
 
     /*
      * init fields in memline struct
@@ -294,8 +307,17 @@ ml_open(buf_T *buf)
     buf->b_ml.ml_stack_top = 0;	/* nothing in the stack */
     buf->b_ml.ml_locked = NULL;	/* no cached block */
     buf->b_ml.ml_line_lnum = 0;	/* no cached line */
+    buf->b_ml.ml_cache = NULL;
+    buf->b_ml.ml_cache_used = 0;
+    buf->b_ml.ml_cache_next = 0;
+    buf->b_ml.ml_cache_hits = 0;
+    buf->b_ml.ml_cache_misses = 0;
 #ifdef FEAT_BYTEOFF
     buf->b_ml.ml_chunksize = NULL;
+    buf->b_ml.ml_chunks_stale = FALSE;
+    buf->b_ml.ml_chunktree = NULL;
+    buf->b_ml.ml_chunktree_size = 0;
+    buf->b_ml.ml_chunktree_valid = FALSE;
 #endif
 
     if (cmdmod.noswapfile)
@@ -320,6 +342,21 @@ ml_open(buf_T *buf)
 #ifdef FEAT_CRYPT
     mfp->mf_buffer = buf;
 #endif
+
+    /*
+     * When a big file is going to be read use a bigger page size, so that
+     * fewer blocks are needed and the tree of pointer blocks is less deep.
+     */
+    if (buf->b_ffname != NULL && mch_stat((char *)buf->b_ffname, &st) >= 0)
+    {
+	page_size = mfp->mf_page_size;
+	while (page_size < ML_BIG_PAGE_SIZE
+			     && st.st_size / page_size > ML_BIG_BLOCK_COUNT)
+	    page_size *= 2;
+	if (page_size != mfp->mf_page_size)
+	    mf_new_page_size(mfp, page_size);
+    }
+
     buf->b_ml.ml_flags = ML_EMPTY;
     buf->b_ml.ml_line_count = 1;
 #ifdef FEAT_LINEBREAK
@@ -538,6 +575,7 @@ ml_set_crypt_key(
 	vim_free(buf->b_ml.ml_stack);
 	buf->b_ml.ml_stack = NULL;
 	buf->b_ml.ml_stack_size = 0;	/* no stack yet */
+	buf->b_ml.ml_cache_used = 0;
 
 	for ( ; !got_int; line_breakcheck())
 	{
@@ -851,9 +889,16 @@ ml_close(buf_T *buf, int del_file)
     if (buf->b_ml.ml_line_lnum != 0 && (buf->b_ml.ml_flags & ML_LINE_DIRTY))
 	vim_free(buf->b_ml.ml_line_ptr);
     vim_free(buf->b_ml.ml_stack);
+    vim_free(buf->b_ml.ml_cache);
+    buf->b_ml.ml_cache = NULL;
+    buf->b_ml.ml_cache_used = 0;
 #ifdef FEAT_BYTEOFF
     vim_free(buf->b_ml.ml_chunksize);
     buf->b_ml.ml_chunksize = NULL;
+    vim_free(buf->b_ml.ml_chunktree);
+    buf->b_ml.ml_chunktree = NULL;
+    buf->b_ml.ml_chunktree_size = 0;
+    buf->b_ml.ml_chunktree_valid = FALSE;
 #endif
     buf->b_ml.ml_mfp = NULL;
 
@@ -1208,6 +1253,8 @@ ml_recover(void)
     buf->b_ml.ml_stack_top = 0;		/* nothing in the stack */
     buf->b_ml.ml_line_lnum = 0;		/* no cached line */
     buf->b_ml.ml_locked = NULL;		/* no locked block */
+    buf->b_ml.ml_cache = NULL;		/* no cached blocks */
+    buf->b_ml.ml_cache_used = 0;
     buf->b_ml.ml_flags = 0;
 #ifdef FEAT_CRYPT
     buf->b_p_key = empty_option;
@@ -2379,6 +2426,57 @@ theend:
     }
 }
 
+/*
+ * ":memstats": list the memfile counters of the loaded buffers.
+ * ":memstats clear": reset the counters.
+ */
+    void
+ex_memstats(exarg_T *eap)
+{
+    buf_T	*buf;
+    memfile_T	*mfp;
+    char_u	*name;
+
+    if (STRCMP(eap->arg, "clear") == 0)
+    {
+	FOR_ALL_BUFFERS(buf)
+	    if (buf->b_ml.ml_mfp != NULL)
+	    {
+		mf_clear_stats(buf->b_ml.ml_mfp);
+		buf->b_ml.ml_cache_hits = 0;
+		buf->b_ml.ml_cache_misses = 0;
+	    }
+	return;
+    }
+    if (*eap->arg != NUL)
+    {
+	EMSG2(_(e_invarg2), eap->arg);
+	return;
+    }
+
+    MSG_PUTS_TITLE(_("\n  BUF PAGESIZE   PAGES     MAX      HITS    MISSES  WRITES RELEASED    WALKS   CACHED NAME"));
+    FOR_ALL_BUFFERS(buf)
+    {
+	mfp = buf->b_ml.ml_mfp;
+	if (mfp == NULL)
+	    continue;
+	msg_putchar('\n');
+	vim_snprintf((char *)IObuff, IOSIZE,
+		"%5d %8u %7u %7u %9ld %9ld %7ld %8ld %8ld %8ld ",
+		buf->b_fnum, mfp->mf_page_size, mfp->mf_used_count,
+		mfp->mf_used_count_max, mfp->mf_hit_count, mfp->mf_miss_count,
+		mfp->mf_write_count, mfp->mf_release_count,
+		buf->b_ml.ml_cache_misses, buf->b_ml.ml_cache_hits);
+	msg_puts(IObuff);
+	name = buf_spname(buf);
+	msg_outtrans(name != NULL ? name : buf->b_fname);
+	out_flush();
+	ui_breakcheck();
+	if (got_int)
+	    break;
+    }
+}
+
 /*
  * NOTE: The pointer returned by the ml_get_*() functions only remains valid
  * until the next call!
@@ -2565,6 +2663,103 @@ ml_append_buf(
 }
 #endif
 
+/*
+ * Append "count" lines from "lines" after line "lnum" (may be 0) in the
+ * current buffer.  Like calling ml_append() for every line, but a line that
+ * goes at the end of the data block that received the previous line is
+ * copied into it directly, without looking up the block again.
+ * Check: The caller of this function should probably also call
+ * appended_lines() once for all the lines.
+ *
+ * Return the number of lines appended, less than "count" for failure.
+ */
+    long
+ml_append_lines(linenr_T lnum, char_u **lines, long count)
+{
+    long	i;
+    colnr_T	len;
+#ifdef FEAT_JOB_CHANNEL
+    int		write_to_channel = curbuf->b_write_to_channel;
+#endif
+
+    /* When starting up, we might still need to create the memfile */
+    if (curbuf->b_ml.ml_mfp == NULL && open_buffer(FALSE, NULL, 0) == FAIL)
+	return 0;
+
+    if (curbuf->b_ml.ml_line_lnum != 0)
+	ml_flush_line(curbuf);
+#ifdef FEAT_JOB_CHANNEL
+    /* Write the new lines to a channel once, below. */
+    curbuf->b_write_to_channel = FALSE;
+#endif
+    for (i = 0; i < count; ++i)
+    {
+	len = (colnr_T)STRLEN(lines[i]) + 1;
+	if (ml_append_locked(curbuf, lnum + i, lines[i], len) == FAIL
+		&& ml_append_int(curbuf, lnum + i, lines[i], len,
+							 FALSE, FALSE) == FAIL)
+	    break;
+    }
+#ifdef FEAT_JOB_CHANNEL
+    curbuf->b_write_to_channel = write_to_channel;
+    if (i > 0 && curbuf->b_write_to_channel)
+	channel_write_new_lines(curbuf);
+#endif
+    return i;
+}
+
+/*
+ * Append line "line" with length "len" (including NUL) after line "lnum" when
+ * "lnum" is the last line in the locked data block and there is room for it.
+ * This is what ml_append_int() does in that situation.
+ * Return FAIL when ml_append_int() must be used.
+ */
+    static int
+ml_append_locked(buf_T *buf, linenr_T lnum, char_u *line, colnr_T len)
+{
+    DATA_BL	*dp;
+    int		idx;
+
+    if (buf->b_ml.ml_locked == NULL || buf->b_ml.ml_locked_high != lnum
+							    || mf_dont_release)
+	return FAIL;
+    dp = (DATA_BL *)(buf->b_ml.ml_locked->bh_data);
+    if ((int)dp->db_free < len + (int)INDEX_SIZE)
+	return FAIL;
+
+    /* Like ml_find_line() does for ML_INSERT */
+    ++buf->b_ml.ml_locked_lineadd;
+    ++buf->b_ml.ml_locked_high;
+    buf->b_ml.ml_cache_used = 0;
+
+    if (lowest_marked && lowest_marked > lnum)
+	lowest_marked = lnum + 1;
+    buf->b_ml.ml_flags &= ~ML_EMPTY;
+    ++buf->b_ml.ml_line_count;
+
+    idx = lnum - buf->b_ml.ml_locked_low + 1;
+    dp->db_txt_start -= len;
+    dp->db_free -= len + INDEX_SIZE;
+    ++(dp->db_line_count);
+    dp->db_index[idx] = dp->db_txt_start;
+    mch_memmove((char *)dp + dp->db_txt_start, line, (size_t)len);
+    buf->b_ml.ml_flags |= (ML_LOCKED_DIRTY | ML_LOCKED_POS);
+
+#ifdef FEAT_BYTEOFF
+    ml_updatechunk(buf, lnum + 1, (long)len, ML_CHNK_ADDLINE);
+#endif
+#ifdef FEAT_NETBEANS_INTG
+    if (netbeans_active())
+    {
+	if (len > 1)
+	    netbeans_inserted(buf, lnum+1, (colnr_T)0, line, len - 1);
+	netbeans_inserted(buf, lnum+1, (colnr_T)(len - 1),
+							   (char_u *)"\n", 1);
+    }
+#endif
+    return OK;
+}
+
     static int
 ml_append_int(
     buf_T	*buf,
@@ -3048,6 +3243,10 @@ ml_append_int(
     }
 
 #ifdef FEAT_BYTEOFF
+    /* When loading a file don't update the chunks for every line, they are
+     * built in one go when they are first needed. */
+    if (newfile)
+	buf->b_ml.ml_chunks_stale = TRUE;
     /* The line was inserted below 'lnum' */
     ml_updatechunk(buf, lnum + 1, (long)len, ML_CHNK_ADDLINE);
 #endif
@@ -3543,6 +3742,85 @@ ml_new_ptr(memfile_T *mfp)
     return hp;
 }
 
+/*
+ * Lookup line "lnum" in the data blocks remembered by ml_find_line().
+ * When found, lock the block and set the stack like ml_find_line() does.
+ * Return NULL when not found.
+ */
+    static bhdr_T *
+ml_find_cached(buf_T *buf, linenr_T lnum)
+{
+    mlcache_T	*mc;
+    bhdr_T	*hp;
+    int		i;
+
+    for (i = 0; i < buf->b_ml.ml_cache_used; ++i)
+    {
+	mc = &buf->b_ml.ml_cache[i];
+	if (mc->mc_low > lnum || mc->mc_high < lnum)
+	    continue;
+
+	/* When a negative block number was changed mf_get() fails, then the
+	 * pointer block needs to be updated by walking the tree. */
+	if (mc->mc_stack_top > buf->b_ml.ml_stack_size
+		|| (hp = mf_get(buf->b_ml.ml_mfp, mc->mc_bnum,
+						   mc->mc_page_count)) == NULL)
+	    return NULL;
+
+	mch_memmove(buf->b_ml.ml_stack, mc->mc_stack,
+				      sizeof(infoptr_T) * mc->mc_stack_top);
+	buf->b_ml.ml_stack_top = mc->mc_stack_top;
+	buf->b_ml.ml_locked = hp;
+	buf->b_ml.ml_locked_low = mc->mc_low;
+	buf->b_ml.ml_locked_high = mc->mc_high;
+	buf->b_ml.ml_locked_lineadd = 0;
+	buf->b_ml.ml_flags &= ~(ML_LOCKED_DIRTY | ML_LOCKED_POS);
+	++buf->b_ml.ml_cache_hits;
+	return hp;
+    }
+    return NULL;
+}
+
+/*
+ * Remember data block "bnum" with lines "low" to "high", just found by
+ * ml_find_line(), together with the current stack.
+ */
+    static void
+ml_add_cached(
+    buf_T	*buf,
+    blocknr_T	bnum,
+    int		page_count,
+    linenr_T	low,
+    linenr_T	high)
+{
+    mlcache_T	*mc;
+
+    if (buf->b_ml.ml_stack_top > MLCACHE_DEPTH)
+	return;
+    if (buf->b_ml.ml_cache == NULL)
+    {
+	buf->b_ml.ml_cache = (mlcache_T *)alloc((unsigned)
+					      sizeof(mlcache_T) * MLCACHE_SIZE);
+	if (buf->b_ml.ml_cache == NULL)
+	    return;
+	buf->b_ml.ml_cache_used = 0;
+    }
+    if (buf->b_ml.ml_cache_used < MLCACHE_SIZE)
+	mc = &buf->b_ml.ml_cache[buf->b_ml.ml_cache_used++];
+    else
+    {
+	mc = &buf->b_ml.ml_cache[buf->b_ml.ml_cache_next];
+	buf->b_ml.ml_cache_next = (buf->b_ml.ml_cache_next + 1) % MLCACHE_SIZE;
+    }
+    mc->mc_bnum = bnum;
+    mc->mc_page_count = page_count;
+    mc->mc_low = low;
+    mc->mc_high = high;
+    mc->mc_stack_top = buf->b_ml.ml_stack_top;
+    mch_memmove(mc->mc_stack, buf->b_ml.ml_stack,
+				      sizeof(infoptr_T) * mc->mc_stack_top);
+}
+
 /*
  * lookup line 'lnum' in a memline
  *
@@ -3576,6 +3854,10 @@ ml_find_line(buf_T *buf, linenr_T lnum, int action)
 
     mfp = buf->b_ml.ml_mfp;
 
+    /* Inserting or deleting lines makes the remembered blocks invalid. */
+    if (action != ML_FIND && action != ML_FLUSH)
+	buf->b_ml.ml_cache_used = 0;
+
     /*
      * If there is a locked block check if the wanted line is in it.
      * If not, flush and release the locked block.
@@ -3626,6 +3908,10 @@ ml_find_line(buf_T *buf, linenr_T lnum, int action)
 
     if (action == ML_FIND)	/* first try stack entries */
     {
+	if ((hp = ml_find_cached(buf, lnum)) != NULL)
+	    return hp;
+	++buf->b_ml.ml_cache_misses;
+
 	for (top = buf->b_ml.ml_stack_top - 1; top >= 0; --top)
 	{
 	    ip = &(buf->b_ml.ml_stack[top]);
@@ -3668,6 +3954,8 @@ ml_find_line(buf_T *buf, linenr_T lnum, int action)
 	    buf->b_ml.ml_locked_high = high;
 	    buf->b_ml.ml_locked_lineadd = 0;
 	    buf->b_ml.ml_flags &= ~(ML_LOCKED_DIRTY | ML_LOCKED_POS);
+	    if (action == ML_FIND)
+		ml_add_cached(buf, bnum, page_count, low, high);
 	    return hp;
 	}
 
@@ -3710,6 +3998,8 @@ ml_find_line(buf_T *buf, linenr_T lnum, int action)
 			bnum = bnum2;
 			pp->pb_pointer[idx].pe_bnum = bnum;
 			dirty = TRUE;
+			/* A remembered block may use the old number. */
+			buf->b_ml.ml_cache_used = 0;
 		    }
 		}
 
@@ -4906,6 +5196,220 @@ ml_crypt_prepare(memfile_T *mfp, off_T offset, int reading)
 #define MLCS_MAXL 800	/* max no of lines in chunk */
 #define MLCS_MINL 400   /* should be half of MLCS_MAXL */
 
+/* Cached position of the last ml_updatechunk() call. */
+static buf_T	*ml_upd_lastbuf = NULL;
+static linenr_T	ml_upd_lastline;
+static linenr_T	ml_upd_lastcurline;
+static int	ml_upd_lastcurix;
+
+/*
+ * The sums of the line counts and sizes of the chunks are kept in a Fenwick
+ * tree, so that the chunk for a line or byte offset can be found without
+ * going over all the chunks.  Entry "i" (starting at one) holds the sum of
+ * chunk "i - 1" and the (i & -i) - 1 chunks before it.
+ * Changing the size of a chunk updates the tree, splitting or joining chunks
+ * marks it invalid, it is then rebuilt when needed.
+ */
+
+/*
+ * Make the Fenwick tree for "buf" valid.
+ * Return FAIL when out of memory.
+ */
+    static int
+ml_chunktree_build(buf_T *buf)
+{
+    chunksize_T	*tree;
+    int		n = buf->b_ml.ml_usedchunks;
+    int		i;
+    int		j;
+
+    if (buf->b_ml.ml_chunktree_valid)
+	return OK;
+    if (buf->b_ml.ml_chunktree_size <= n)
+    {
+	vim_free(buf->b_ml.ml_chunktree);
+	buf->b_ml.ml_chunktree_size = buf->b_ml.ml_numchunks + 1;
+	buf->b_ml.ml_chunktree = (chunksize_T *)alloc((unsigned)
+			   sizeof(chunksize_T) * buf->b_ml.ml_chunktree_size);
+	if (buf->b_ml.ml_chunktree == NULL)
+	{
+	    buf->b_ml.ml_chunktree_size = 0;
+	    return FAIL;
+	}
+    }
+    tree = buf->b_ml.ml_chunktree;
+    mch_memmove(tree + 1, buf->b_ml.ml_chunksize, sizeof(chunksize_T) * n);
+    for (i = 1; i <= n; ++i)
+    {
+	j = i + (i & -i);
+	if (j <= n)
+	{
+	    tree[j].mlcs_numlines += tree[i].mlcs_numlines;
+	    tree[j].mlcs_totalsize += tree[i].mlcs_totalsize;
+	}
+    }
+    buf->b_ml.ml_chunktree_valid = TRUE;
+    return OK;
+}
+
+/*
+ * Add "lines" and "size" to chunk "ix" in the Fenwick tree of "buf".
+ */
+    static void
+ml_chunktree_add(buf_T *buf, int ix, int lines, long size)
+{
+    int		i;
+
+    if (!buf->b_ml.ml_chunktree_valid)
+	return;
+    for (i = ix + 1; i <= buf->b_ml.ml_usedchunks; i += i & -i)
+    {
+	buf->b_ml.ml_chunktree[i].mlcs_numlines += lines;
+	buf->b_ml.ml_chunktree[i].mlcs_totalsize += size;
+    }
+}
+
+/*
+ * Find the chunk that contains line "lnum", or byte "offset" when "lnum" is
+ * zero.  "ffdos" is one when every line has an extra CR.
+ * The last chunk is returned when going beyond the end.
+ * Returns the index of the chunk, "*curline" is set to its first line and
+ * "*sizep" to the number of bytes before it.  For "offset" this includes the
+ * CR characters.
+ */
+    static int
+ml_find_chunk(
+    buf_T	*buf,
+    linenr_T	lnum,
+    long	offset,
+    int		ffdos,
+    linenr_T	*curline,
+    long	*sizep)
+{
+    chunksize_T	*tree;
+    int		last = buf->b_ml.ml_usedchunks - 1;
+    int		curix = 0;
+    int		bit;
+    linenr_T	lines = 0;
+    long	size = 0;
+
+    if (ml_chunktree_build(buf) == FAIL)
+    {
+	/* Out of memory: go over the chunks one by one. */
+	while (curix < last
+		&& ((lnum != 0
+		  && lnum > lines + buf->b_ml.ml_chunksize[curix].mlcs_numlines)
+		    || (offset != 0
+		   && offset > size + buf->b_ml.ml_chunksize[curix].mlcs_totalsize
+			  + ffdos * buf->b_ml.ml_chunksize[curix].mlcs_numlines)))
+	{
+	    lines += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
+	    size += buf->b_ml.ml_chunksize[curix].mlcs_totalsize;
+	    if (offset != 0 && ffdos)
+		size += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
+	    curix++;
+	}
+    }
+    else
+    {
+	tree = buf->b_ml.ml_chunktree;
+	for (bit = 1; bit * 2 <= last; bit *= 2)
+	    ;
+	for ( ; bit > 0; bit /= 2)
+	    if (curix + bit <= last
+		    && ((lnum != 0
+			    && lnum > lines + tree[curix + bit].mlcs_numlines)
+			|| (offset != 0
+			    && offset > size + tree[curix + bit].mlcs_totalsize
+				+ ffdos * (lines + tree[curix + bit].mlcs_numlines))))
+	    {
+		curix += bit;
+		lines += tree[curix].mlcs_numlines;
+		size += tree[curix].mlcs_totalsize;
+	    }
+	if (offset != 0 && ffdos)
+	    size += lines;
+    }
+    *curline = lines + 1;
+    *sizep = size;
+    return curix;
+}
+
+/*
+ * Build the chunks for "buf" from scratch, going over the data blocks once.
+ * Used when updating the chunks was postponed while loading a file.
+ * On failure ml_usedchunks is set to -1.
+ */
+    static void
+ml_rebuild_chunks(buf_T *buf)
+{
+    int		numchunks = buf->b_ml.ml_line_count / MLCS_MINL + 2;
+    chunksize_T	*curchnk;
+    linenr_T	curline;
+    bhdr_T	*hp;
+    DATA_BL	*dp;
+    int		count;		/* number of entries in block */
+    int		idx;
+    int		text_end;
+    int		text_start;
+
+    buf->b_ml.ml_chunks_stale = FALSE;
+    buf->b_ml.ml_chunktree_valid = FALSE;
+    ml_upd_lastbuf = NULL;	/* Force recalc of curix & curline */
+
+    if (buf->b_ml.ml_chunksize == NULL || buf->b_ml.ml_numchunks < numchunks)
+    {
+	vim_free(buf->b_ml.ml_chunksize);
+	buf->b_ml.ml_chunksize = (chunksize_T *)
+			    alloc((unsigned)sizeof(chunksize_T) * numchunks);
+	if (buf->b_ml.ml_chunksize == NULL)
+	{
+	    buf->b_ml.ml_usedchunks = -1;
+	    return;
+	}
+	buf->b_ml.ml_numchunks = numchunks;
+    }
+
+    curchnk = buf->b_ml.ml_chunksize;
+    curchnk->mlcs_numlines = 0;
+    curchnk->mlcs_totalsize = 0;
+    buf->b_ml.ml_usedchunks = 1;
+
+    for (curline = 1; curline <= buf->b_ml.ml_line_count;
+					 curline = buf->b_ml.ml_locked_high + 1)
+    {
+	if ((hp = ml_find_line(buf, curline, ML_FIND)) == NULL)
+	{
+	    buf->b_ml.ml_usedchunks = -1;
+	    return;
+	}
+	dp = (DATA_BL *)(hp->bh_data);
+	count = (long)(buf->b_ml.ml_locked_high) -
+					    (long)(buf->b_ml.ml_locked_low) + 1;
+	idx = curline - buf->b_ml.ml_locked_low;
+	if (idx == 0)	/* first line in block, text at the end */
+	    text_end = dp->db_txt_end;
+	else
+	    text_end = ((dp->db_index[idx - 1]) & DB_INDEX_MASK);
+	for ( ; idx < count; ++idx)
+	{
+	    /* Start a new chunk after MLCS_MINL lines, like loading a file
+	     * line by line does. */
+	    if (curchnk->mlcs_numlines >= MLCS_MINL)
+	    {
+		++curchnk;
+		++buf->b_ml.ml_usedchunks;
+		curchnk->mlcs_numlines = 0;
+		curchnk->mlcs_totalsize = 0;
+	    }
+	    text_start = ((dp->db_index[idx]) & DB_INDEX_MASK);
+	    ++curchnk->mlcs_numlines;
+	    curchnk->mlcs_totalsize += text_end - text_start;
+	    text_end = text_start;
+	}
+    }
+}
+
 /*
  * Keep information for finding byte offset of a line, updtype may be one of:
  * ML_CHNK_ADDLINE: Add len to parent chunk, possibly splitting it
@@ -4920,20 +5424,17 @@ ml_updatechunk(
     long	len,
     int		updtype)
 {
-    static buf_T	*ml_upd_lastbuf = NULL;
-    static linenr_T	ml_upd_lastline;
-    static linenr_T	ml_upd_lastcurline;
-    static int		ml_upd_lastcurix;
-
     linenr_T		curline = ml_upd_lastcurline;
     int			curix = ml_upd_lastcurix;
     long		size;
+    long		before;
     chunksize_T		*curchnk;
     int			rest;
     bhdr_T		*hp;
     DATA_BL		*dp;
 
-    if (buf->b_ml.ml_usedchunks == -1 || len == 0)
+    if (buf->b_ml.ml_usedchunks == -1 || buf->b_ml.ml_chunks_stale
+								   || len == 0)
 	return;
     if (buf->b_ml.ml_chunksize == NULL)
     {
@@ -4948,6 +5449,7 @@ ml_updatechunk(
 	buf->b_ml.ml_usedchunks = 1;
 	buf->b_ml.ml_chunksize[0].mlcs_numlines = 1;
 	buf->b_ml.ml_chunksize[0].mlcs_totalsize = 1;
+	buf->b_ml.ml_chunktree_valid = FALSE;
     }
 
     if (updtype == ML_CHNK_UPDLINE && buf->b_ml.ml_line_count == 1)
@@ -4959,6 +5461,7 @@ ml_updatechunk(
 	buf->b_ml.ml_chunksize[0].mlcs_numlines = 1;
 	buf->b_ml.ml_chunksize[0].mlcs_totalsize =
 				  (long)STRLEN(buf->b_ml.ml_line_ptr) + 1;
+	buf->b_ml.ml_chunktree_valid = FALSE;
 	return;
     }
 
@@ -4968,15 +5471,7 @@ ml_updatechunk(
      */
     if (buf != ml_upd_lastbuf || line != ml_upd_lastline + 1
 	    || updtype != ML_CHNK_ADDLINE)
-    {
-	for (curline = 1, curix = 0;
-	     curix < buf->b_ml.ml_usedchunks - 1
-	     && line >= curline + buf->b_ml.ml_chunksize[curix].mlcs_numlines;
-	     curix++)
-	{
-	    curline += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
-	}
-    }
+	curix = ml_find_chunk(buf, line, 0L, 0, &curline, &before);
     else if (line >= curline + buf->b_ml.ml_chunksize[curix].mlcs_numlines
 		 && curix < buf->b_ml.ml_usedchunks - 1)
     {
@@ -4989,6 +5484,8 @@ ml_updatechunk(
     if (updtype == ML_CHNK_DELLINE)
 	len = -len;
     curchnk->mlcs_totalsize += len;
+    ml_chunktree_add(buf, curix, updtype == ML_CHNK_ADDLINE ? 1
+				 : updtype == ML_CHNK_DELLINE ? -1 : 0, len);
     if (updtype == ML_CHNK_ADDLINE)
     {
 	curchnk->mlcs_numlines++;
@@ -5061,6 +5558,7 @@ ml_updatechunk(
 	    buf->b_ml.ml_chunksize[curix].mlcs_totalsize = size;
 	    buf->b_ml.ml_chunksize[curix + 1].mlcs_totalsize -= size;
 	    buf->b_ml.ml_usedchunks++;
+	    buf->b_ml.ml_chunktree_valid = FALSE;
 	    ml_upd_lastbuf = NULL;   /* Force recalc of curix & curline */
 	    return;
 	}
@@ -5074,6 +5572,7 @@ ml_updatechunk(
 	     */
 	    curchnk = buf->b_ml.ml_chunksize + curix + 1;
 	    buf->b_ml.ml_usedchunks++;
+	    buf->b_ml.ml_chunktree_valid = FALSE;
 	    if (line == buf->b_ml.ml_line_count)
 	    {
 		curchnk->mlcs_numlines = 0;
@@ -5119,6 +5618,7 @@ ml_updatechunk(
 	else if (curix == 0 && curchnk->mlcs_numlines <= 0)
 	{
 	    buf->b_ml.ml_usedchunks--;
+	    buf->b_ml.ml_chunktree_valid = FALSE;
 	    mch_memmove(buf->b_ml.ml_chunksize, buf->b_ml.ml_chunksize + 1,
 			buf->b_ml.ml_usedchunks * sizeof(chunksize_T));
 	    return;
@@ -5134,6 +5634,7 @@ ml_updatechunk(
 	curchnk[-1].mlcs_numlines += curchnk->mlcs_numlines;
 	curchnk[-1].mlcs_totalsize += curchnk->mlcs_totalsize;
 	buf->b_ml.ml_usedchunks--;
+	buf->b_ml.ml_chunktree_valid = FALSE;
 	if (curix < buf->b_ml.ml_usedchunks)
 	{
 	    mch_memmove(buf->b_ml.ml_chunksize + curix,
@@ -5159,7 +5660,6 @@ ml_updatechunk(
 ml_find_line_or_offset(buf_T *buf, linenr_T lnum, long *offp)
 {
     linenr_T	curline;
-    int		curix;
     long	size;
     bhdr_T	*hp;
     DATA_BL	*dp;
@@ -5175,6 +5675,8 @@ ml_find_line_or_offset(buf_T *buf, linenr_T lnum, long *offp)
     /* take care of cached line first */
     ml_flush_line(curbuf);
 
+    if (buf->b_ml.ml_chunks_stale)
+	ml_rebuild_chunks(buf);
     if (buf->b_ml.ml_usedchunks == -1
 	    || buf->b_ml.ml_chunksize == NULL
 	    || lnum < 0)
@@ -5187,24 +5689,10 @@ ml_find_line_or_offset(buf_T *buf, linenr_T lnum, long *offp)
     if (lnum == 0 && offset <= 0)
 	return 1;   /* Not a "find offset" and offset 0 _must_ be in line 1 */
     /*
-     * Find the last chunk before the one containing our line. Last chunk is
-     * special because it will never qualify
+     * Find the chunk containing our line. Last chunk is special because it
+     * will never qualify
      */
-    curline = 1;
-    curix = size = 0;
-    while (curix < buf->b_ml.ml_usedchunks - 1
-	    && ((lnum != 0
-	     && lnum >= curline + buf->b_ml.ml_chunksize[curix].mlcs_numlines)
-		|| (offset != 0
-	       && offset > size + buf->b_ml.ml_chunksize[curix].mlcs_totalsize
-		      + ffdos * buf->b_ml.ml_chunksize[curix].mlcs_numlines)))
-    {
-	curline += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
-	size += buf->b_ml.ml_chunksize[curix].mlcs_totalsize;
-	if (offset && ffdos)
-	    size += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
-	curix++;
-    }
+    (void)ml_find_chunk(buf, lnum, offset, ffdos, &curline, &size);
 
     while ((lnum != 0 && curline < lnum) || (offset != 0 && size < offset))
     {
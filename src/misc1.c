@@ -2998,6 +2998,10 @@ changed_common(
     /* mark the buffer as modified */
     changed();
 
+#ifdef FEAT_SEARCH_EXTRA
+    search_index_changed(curbuf, lnum, lnume, xtra);
+#endif
+
     /* set the '. mark */
     if (!cmdmod.keepjumps)
     {
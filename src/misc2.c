@@ -1849,20 +1849,25 @@ vim_strnicmp(char *s1, char *s2, size_t len)
 vim_strchr(char_u *string, int c)
 {
     char_u	*p;
+#ifdef FEAT_MBYTE
     int		b;
+#endif
 
     p = string;
 #ifdef FEAT_MBYTE
     if (enc_utf8 && c >= 0x80)
     {
-	while (*p != NUL)
-	{
-	    int l = (*mb_ptr2len)(p);
+	char_u	buf[MB_MAXBYTES + 1];
 
+	/* The lead byte can't be part of another character, find it with
+	 * strchr() and then check the whole character. */
+	(void)utf_char2bytes(c, buf);
+	while ((p = (char_u *)strchr((char *)p, buf[0])) != NULL)
+	{
 	    /* Avoid matching an illegal byte here. */
-	    if (utf_ptr2char(p) == c && l > 1)
+	    if (utf_ptr2char(p) == c && utf_ptr2len(p) > 1)
 		return p;
-	    p += l;
+	    ++p;
 	}
 	return NULL;
     }
@@ -1879,8 +1884,9 @@ vim_strchr(char_u *string, int c)
 	}
 	return NULL;
     }
-    if (has_mbyte)
+    if (has_mbyte && !enc_utf8)
     {
+	/* A trail byte may be equal to "c", need to skip over characters. */
 	while ((b = *p) != NUL)
 	{
 	    if (b == c)
@@ -1890,13 +1896,11 @@ vim_strchr(char_u *string, int c)
 	return NULL;
     }
 #endif
-    while ((b = *p) != NUL)
-    {
-	if (b == c)
-	    return p;
-	++p;
-    }
-    return NULL;
+    /* A byte below 0x80 is never part of a UTF-8 multi-byte character.  The
+     * library strchr() is usually much faster than a loop. */
+    if (c <= 0 || c > 255)
+	return NULL;
+    return (char_u *)strchr((char *)p, c);
 }
 
 /*
@@ -1907,15 +1911,9 @@ vim_strchr(char_u *string, int c)
     char_u  *
 vim_strbyte(char_u *string, int c)
 {
-    char_u	*p = string;
-
-    while (*p != NUL)
-    {
-	if (*p == c)
-	    return p;
-	++p;
-    }
-    return NULL;
+    if (c <= 0 || c > 255)
+	return NULL;
+    return (char_u *)strchr((char *)string, c);
 }
 
 /*
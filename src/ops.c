@@ -3331,6 +3331,8 @@ do_put(
     char_u	*insert_string = NULL;
     int		allocated = FALSE;
     long	cnt;
+    long	n;
+    long	added;
 
 #ifdef FEAT_CLIPBOARD
     /* Adjust register name for "unnamed" in 'clipboard'. */
@@ -3851,6 +3853,23 @@ do_put(
 		    i = 1;
 		}
 
+		if (!(flags & PUT_FIXINDENT))
+		{
+		    /* Append all lines in one go.  For MCHAR the last one was
+		     * inserted above. */
+		    added = y_size - i - (y_type == MCHAR ? 1 : 0);
+		    n = ml_append_lines(lnum, y_array + i, added);
+		    lnum += n;
+		    nr_lines += n;
+		    if (n < added)
+			goto error;
+		    if (y_type == MCHAR)
+		    {
+			lnum++;
+			++nr_lines;
+		    }
+		    i = y_size;
+		}
 		for (; i < y_size; ++i)
 		{
 		    if ((y_type != MCHAR || i < y_size - 1)
@@ -1160,6 +1160,13 @@ static struct vimoption options[] =
 			    {(char_u *)0L, (char_u *)0L}
 #endif
 			    SCRIPTID_INIT},
+    {"filewatch",   "fw",   P_BOOL|P_VI_DEF,
+#ifdef FEAT_FILEWATCH
+			    (char_u *)&p_fw, PV_NONE,
+#else
+			    (char_u *)NULL, PV_NONE,
+#endif
+			    {(char_u *)FALSE, (char_u *)0L} SCRIPTID_INIT},
     {"fillchars",   "fcs",  P_STRING|P_VI_DEF|P_RALL|P_ONECOMMA|P_NODUP,
 #if defined(FEAT_WINDOWS) || defined(FEAT_FOLDING)
 			    (char_u *)&p_fcs, PV_NONE,
@@ -2373,7 +2380,7 @@ static struct vimoption options[] =
 			    {(char_u *)8L, (char_u *)0L} SCRIPTID_INIT},
     {"shortmess",   "shm",  P_STRING|P_VIM|P_FLAGLIST,
 			    (char_u *)&p_shm, PV_NONE,
-			    {(char_u *)"", (char_u *)"filnxtToO"}
+			    {(char_u *)"S", (char_u *)"filnxtToOS"}
 			    SCRIPTID_INIT},
     {"shortname",   "sn",   P_BOOL|P_VI_DEF,
 			    (char_u *)&p_sn, PV_SN,
@@ -2542,6 +2549,13 @@ static struct vimoption options[] =
     {"switchbuf",   "swb",  P_STRING|P_VI_DEF|P_ONECOMMA|P_NODUP,
 			    (char_u *)&p_swb, PV_NONE,
 			    {(char_u *)"", (char_u *)0L} SCRIPTID_INIT},
+    {"syncachedir", "scdir", P_STRING|P_EXPAND|P_SECURE|P_VI_DEF,
+#ifdef FEAT_SYN_CACHE
+			    (char_u *)&p_scdir, PV_NONE,
+#else
+			    (char_u *)NULL, PV_NONE,
+#endif
+			    {(char_u *)"", (char_u *)0L} SCRIPTID_INIT},
     {"synmaxcol",   "smc",  P_NUM|P_VI_DEF|P_RBUF,
 #ifdef FEAT_SYN_HL
 			    (char_u *)&p_smc, PV_SMC,
@@ -3193,7 +3207,7 @@ set_init_1(void)
     if (mch_getenv((char_u *)"VIM_POSIX") != NULL)
     {
 	set_string_default("cpo", (char_u *)CPO_ALL);
-	set_string_default("shm", (char_u *)"A");
+	set_string_default("shm", (char_u *)"AS");
     }
 
     /*
@@ -8209,6 +8223,15 @@ set_bool_option(
     }
 #endif
 
+#ifdef FEAT_FILEWATCH
+    else if ((int *)varp == &p_fw)
+    {
+	/* Stop watching files, they are watched again when checked. */
+	if (!p_fw)
+	    mch_watch_stop();
+    }
+#endif
+
 #ifdef FEAT_AUTOCHDIR
     else if ((int *)varp == &p_acd)
     {
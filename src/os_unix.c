@@ -46,6 +46,10 @@
 static int selinux_enabled = -1;
 #endif
 
+#ifdef FEAT_FILEWATCH
+# include <sys/inotify.h>
+#endif
+
 #ifdef HAVE_SMACK
 # include <attr/xattr.h>
 # include <linux/xattr.h>
@@ -188,6 +192,11 @@ static int do_xterm_trace(void);
 # define XT_TRACE_DELAY	50	/* delay for xterm tracing */
 #endif
 
+#ifdef FEAT_FILEWATCH
+static void watch_read_events(void);
+static void watch_remove(buf_T *buf);
+#endif
+
 static void handle_resize(void);
 
 #if defined(SIGWINCH)
@@ -244,6 +253,10 @@ typedef struct
 static xsmp_config_T xsmp;
 #endif
 
+#ifdef FEAT_FILEWATCH
+static int watch_fd = -1;	/* inotify file descriptor for 'filewatch' */
+#endif
+
 #ifdef SYS_SIGLIST_DECLARED
 /*
  * I have seen
@@ -469,6 +482,11 @@ mch_inchar(
 	 * Also done when interrupted by SIGWINCH.
 	 */
 	before_blocking();
+
+	/* A callback invoked while parsing syntax ahead may have used
+	 * feedkeys(). */
+	if (typebuf_changed(tb_change_cnt))
+	    return 0;
 	break;
     }
 
@@ -5525,7 +5543,8 @@ RealWaitForChar(int fd, long msec, int *check_for_gpm UNUSED, int *interrupted)
 {
     int		ret;
     int		result;
-#if defined(FEAT_XCLIPBOARD) || defined(USE_XSMP) || defined(FEAT_MZSCHEME)
+#if defined(FEAT_XCLIPBOARD) || defined(USE_XSMP) || defined(FEAT_MZSCHEME) \
+	|| defined(FEAT_FILEWATCH)
     static int	busy = FALSE;
 
     /* May retry getting characters after an event was handled. */
@@ -5570,6 +5589,9 @@ RealWaitForChar(int fd, long msec, int *check_for_gpm UNUSED, int *interrupted)
 # endif
 # ifdef USE_XSMP
 	int		xsmp_idx = -1;
+# endif
+# ifdef FEAT_FILEWATCH
+	int		watch_idx = -1;
 # endif
 	int		towait = (int)msec;
 
@@ -5613,6 +5635,15 @@ RealWaitForChar(int fd, long msec, int *check_for_gpm UNUSED, int *interrupted)
 	    nfd++;
 	}
 # endif
+# ifdef FEAT_FILEWATCH
+	if (watch_fd >= 0)
+	{
+	    watch_idx = nfd;
+	    fds[nfd].fd = watch_fd;
+	    fds[nfd].events = POLLIN;
+	    nfd++;
+	}
+# endif
 #ifdef FEAT_JOB_CHANNEL
 	nfd = channel_poll_setup(nfd, &fds);
 #endif
@@ -5665,6 +5696,14 @@ RealWaitForChar(int fd, long msec, int *check_for_gpm UNUSED, int *interrupted)
 		finished = FALSE;	/* Try again */
 	}
 # endif
+# ifdef FEAT_FILEWATCH
+	if (watch_idx >= 0 && (fds[watch_idx].revents & POLLIN))
+	{
+	    watch_read_events();
+	    if (--ret == 0)
+		finished = FALSE;	/* Try again */
+	}
+# endif
 #ifdef FEAT_JOB_CHANNEL
 	if (ret > 0)
 	    ret = channel_poll_check(ret, &fds);
@@ -5741,6 +5780,14 @@ select_eintr:
 		maxfd = xsmp_icefd;
 	}
 # endif
+# ifdef FEAT_FILEWATCH
+	if (watch_fd >= 0)
+	{
+	    FD_SET(watch_fd, &rfds);
+	    if (maxfd < watch_fd)
+		maxfd = watch_fd;
+	}
+# endif
 # ifdef FEAT_JOB_CHANNEL
 	maxfd = channel_select_setup(maxfd, &rfds, &wfds);
 # endif
@@ -5827,6 +5874,14 @@ select_eintr:
 	    }
 	}
 # endif
+# ifdef FEAT_FILEWATCH
+	if (ret > 0 && watch_fd >= 0 && FD_ISSET(watch_fd, &rfds))
+	{
+	    watch_read_events();
+	    if (--ret == 0)
+		finished = FALSE;   /* keep going if event was only one */
+	}
+# endif
 #ifdef FEAT_JOB_CHANNEL
 	if (ret > 0)
 	    ret = channel_select_check(ret, &rfds, &wfds);
@@ -7522,6 +7577,130 @@ xsmp_close(void)
 }
 #endif /* USE_XSMP */
 
+#if defined(FEAT_FILEWATCH) || defined(PROTO)
+/*
+ * Watching files for 'filewatch'.  The file of a buffer is watched once it
+ * has been checked by buf_check_timestamp().  It only needs to be checked
+ * again after an event for the file was received.
+ */
+# define WATCH_EVENTS	(IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE \
+					       | IN_MOVE_SELF | IN_DELETE_SELF)
+
+/*
+ * Read the pending inotify events and flag the buffers they are for.
+ */
+    static void
+watch_read_events(void)
+{
+    union
+    {
+	struct inotify_event	ev;	/* for alignment */
+	char			buf[4096];
+    } u;
+    struct inotify_event	*ev;
+    buf_T	*buf;
+    long	len;
+    long	off;
+
+    if (watch_fd < 0)
+	return;
+    while ((len = read(watch_fd, u.buf, sizeof(u.buf))) > 0)
+	for (off = 0; off < len; off += sizeof(struct inotify_event) + ev->len)
+	{
+	    ev = (struct inotify_event *)(u.buf + off);
+
+	    /* When events were lost all files may have changed. */
+	    FOR_ALL_BUFFERS(buf)
+		if (buf->b_watch_wd > 0 && (buf->b_watch_wd == ev->wd
+					       || (ev->mask & IN_Q_OVERFLOW)))
+		{
+		    buf->b_watch_changed = TRUE;
+		    if (ev->mask & IN_IGNORED)
+			buf->b_watch_wd = 0;	/* watch was removed */
+		}
+	}
+}
+
+/*
+ * Stop watching the file of buffer "buf", unless another buffer is watching
+ * the same file.
+ */
+    static void
+watch_remove(buf_T *buf)
+{
+    buf_T	*bp;
+
+    FOR_ALL_BUFFERS(bp)
+	if (bp != buf && bp->b_watch_wd == buf->b_watch_wd)
+	    break;
+    if (bp == NULL)
+	inotify_rm_watch(watch_fd, buf->b_watch_wd);
+    buf->b_watch_wd = 0;
+}
+
+/*
+ * Called before checking if the file of buffer "buf" was changed.
+ * Returns FALSE when the file is being watched and no event was received for
+ * it, there is no need to check it then.  Otherwise starts watching the file
+ * and returns TRUE.
+ */
+    int
+mch_watch_check(buf_T *buf)
+{
+    int		wd;
+
+    if (!p_fw)
+	return TRUE;
+    if (watch_fd < 0)
+    {
+	watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watch_fd < 0)
+	    return TRUE;
+    }
+    watch_read_events();
+    if (buf->b_watch_wd > 0 && !buf->b_watch_changed)
+	return FALSE;
+
+    /* Also when already watching: the file may have been replaced by another
+     * one, e.g. when it was written by renaming a new file.  An event
+     * received after this is for the next check. */
+    wd = inotify_add_watch(watch_fd, (char *)buf->b_ffname, WATCH_EVENTS);
+    if (buf->b_watch_wd > 0 && buf->b_watch_wd != wd)
+	watch_remove(buf);
+    buf->b_watch_wd = wd > 0 ? wd : 0;
+    buf->b_watch_changed = FALSE;
+    return TRUE;
+}
+
+/*
+ * Stop watching the file of buffer "buf".  Used when the buffer is unloaded
+ * or its name changes.
+ */
+    void
+mch_watch_forget(buf_T *buf)
+{
+    if (buf->b_watch_wd > 0)
+	watch_remove(buf);
+}
+
+/*
+ * Stop watching all files.  Used when 'filewatch' is reset.
+ */
+    void
+mch_watch_stop(void)
+{
+    buf_T	*buf;
+
+    FOR_ALL_BUFFERS(buf)
+	buf->b_watch_wd = 0;
+    if (watch_fd >= 0)
+    {
+	close(watch_fd);
+	watch_fd = -1;
+    }
+}
+#endif
+
 
 #ifdef EBCDIC
 /* Translate character to its CTRL- value */
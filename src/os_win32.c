@@ -1748,6 +1748,11 @@ mch_inchar(
 	    }
 #endif
 	    before_blocking();
+
+	    /* A callback invoked while parsing syntax ahead may have used
+	     * feedkeys(). */
+	    if (typebuf_changed(tb_change_cnt))
+		return 0;
 	}
     }
 
@@ -4,6 +4,7 @@ int mf_open_file(memfile_T *mfp, char_u *fname);
 void mf_close(memfile_T *mfp, int del_file);
 void mf_close_file(buf_T *buf, int getlines);
 void mf_new_page_size(memfile_T *mfp, unsigned new_size);
+void mf_clear_stats(memfile_T *mfp);
 bhdr_T *mf_new(memfile_T *mfp, int negative, int page_count);
 bhdr_T *mf_get(memfile_T *mfp, blocknr_T nr, int page_count);
 void mf_put(memfile_T *mfp, bhdr_T *hp, int dirty, int infile);
@@ -13,6 +13,7 @@ void ml_recover(void);
 int recover_names(char_u *fname, int list, int nr, char_u **fname_out);
 void ml_sync_all(int check_file, int check_char);
 void ml_preserve(buf_T *buf, int message);
+void ex_memstats(exarg_T *eap);
 char_u *ml_get(linenr_T lnum);
 char_u *ml_get_pos(pos_T *pos);
 char_u *ml_get_curline(void);
@@ -21,6 +22,7 @@ char_u *ml_get_buf(buf_T *buf, linenr_T lnum, int will_change);
 int ml_line_alloced(void);
 int ml_append(linenr_T lnum, char_u *line, colnr_T len, int newfile);
 int ml_append_buf(buf_T *buf, linenr_T lnum, char_u *line, colnr_T len, int newfile);
+long ml_append_lines(linenr_T lnum, char_u **lines, long count);
 int ml_replace(linenr_T lnum, char_u *line, int copy);
 int ml_delete(linenr_T lnum, int message);
 void ml_setmarked(linenr_T lnum);
@@ -79,4 +79,7 @@ void clip_xterm_set_selection(VimClipboard *cbd);
 int xsmp_handle_requests(void);
 void xsmp_init(void);
 void xsmp_close(void);
+int mch_watch_check(buf_T *buf);
+void mch_watch_forget(buf_T *buf);
+void mch_watch_stop(void);
 /* vim: set ft=c : */
@@ -55,4 +55,6 @@ void showruler(int always);
 int number_width(win_T *wp);
 int screen_screencol(void);
 int screen_screenrow(void);
+void ex_redrawprofile(exarg_T *eap);
+void redraw_prof_end(int item, proftime_T *tm);
 /* vim: set ft=c : */
@@ -19,6 +19,9 @@ char_u *last_search_pat(void);
 void reset_search_dir(void);
 void set_last_search_pat(char_u *s, int idx, int magic, int setlast);
 void last_pat_prog(regmmatch_T *regmatch);
+void search_index_free(buf_T *buf);
+void search_index_changed(buf_T *buf, linenr_T lnum, linenr_T lnume, long xtra);
+int search_index_skip_line(buf_T *buf, linenr_T lnum, int ic);
 int searchit(win_T *win, buf_T *buf, pos_T *pos, int dir, char_u *pat, long count, int options, int pat_use, linenr_T stop_lnum, proftime_T *tm);
 void set_search_direction(int cdir);
 int do_search(oparg_T *oap, int dirc, char_u *pat, long count, int options, proftime_T *tm);
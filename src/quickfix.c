@@ -139,11 +139,16 @@ static void	qf_fill_buffer(qf_info_T *qi, buf_T *buf, qfline_T *old_last);
 #endif
 static char_u	*get_mef_name(void);
 static void	restore_start_dir(char_u *dirname_start);
+static int	vgr_may_match_file(char_u *fname, char_u *text, int len, int ic);
+static int	vgr_find_text(char_u *buf, long buflen, char_u *text, int len, int ic);
 static buf_T	*load_dummy_buffer(char_u *fname, char_u *dirname_start, char_u *resulting_dir);
 static void	wipe_dummy_buffer(buf_T *buf, char_u *dirname_start);
 static void	unload_dummy_buffer(buf_T *buf, char_u *dirname_start);
 static qf_info_T *ll_get_or_alloc_list(win_T *);
 
+#define VGR_MUST_LEN	40	/* max length of text that a match contains */
+#define VGR_BUFSIZE	65536	/* block size for checking a file */
+
 /* Quickfix window check helper macro */
 #define IS_QF_WINDOW(wp) (bt_quickfix(wp->w_buffer) && wp->w_llist_ref == NULL)
 /* Location list window check helper macro */
@@ -3952,6 +3957,9 @@ ex_vimgrep(exarg_T *eap)
     char_u	*dirname_start = NULL;
     char_u	*dirname_now = NULL;
     char_u	*target_dir = NULL;
+    char_u	must_text[VGR_MUST_LEN];
+    int		must_len;
+    int		must_ic;
 #ifdef FEAT_AUTOCMD
     char_u	*au_name =  NULL;
 
@@ -4018,6 +4026,8 @@ ex_vimgrep(exarg_T *eap)
 	goto theend;
     regmatch.rmm_ic = p_ic;
     regmatch.rmm_maxcol = 0;
+    must_len = vim_regmust_text(regmatch.regprog, regmatch.rmm_ic,
+				      must_text, VGR_MUST_LEN, &must_ic);
 
     p = skipwhite(p);
     if (*p == NUL)
@@ -4087,6 +4097,12 @@ ex_vimgrep(exarg_T *eap)
 	buf = buflist_findname_exp(fnames[fi]);
 	if (buf == NULL || buf->b_ml.ml_mfp == NULL)
 	{
+	    /* Loading a file is slow.  Skip it when it doesn't contain the
+	     * text that every match has. */
+	    if (must_len > 0
+		   && !vgr_may_match_file(fname, must_text, must_len, must_ic))
+		continue;
+
 	    /* Remember that a buffer with this name already exists. */
 	    duplicate_name = (buf != NULL);
 	    using_dummy = TRUE;
@@ -4344,6 +4360,106 @@ restore_start_dir(char_u *dirname_start)
     }
 }
 
+/*
+ * Return FALSE if file "fname" can't contain a match, because it doesn't
+ * contain "text", "len" bytes of ASCII that every match contains.  Return
+ * TRUE when it may match or can't be checked: when autocommands may change
+ * the text when loading it, when it is encrypted or when it contains a NUL
+ * byte, e.g. because it is in UTF-16.
+ */
+    static int
+vgr_may_match_file(char_u *fname, char_u *text, int len, int ic)
+{
+    int		fd;
+    char_u	*buf;
+    long	size;
+    long	keep = 0;
+    int		first = TRUE;
+    int		found = FALSE;
+
+#ifdef FEAT_AUTOCMD
+    if (!is_autocmd_blocked()
+	    && (has_autocmd(EVENT_BUFREADCMD, fname, NULL)
+		|| has_autocmd(EVENT_BUFREADPRE, fname, NULL)
+		|| has_autocmd(EVENT_BUFREADPOST, fname, NULL)
+		|| has_autocmd(EVENT_FILEREADPOST, fname, NULL)))
+	return TRUE;
+#endif
+
+    fd = mch_open((char *)fname, O_RDONLY | O_EXTRA, 0);
+    if (fd < 0)
+	return TRUE;
+    buf = alloc(VGR_BUFSIZE + len);
+    if (buf == NULL)
+    {
+	close(fd);
+	return TRUE;
+    }
+    for (;;)
+    {
+	size = read_eintr(fd, buf + keep, VGR_BUFSIZE);
+	if (size <= 0)
+	{
+	    /* Let loading the file give the error message. */
+	    found = size < 0;
+	    break;
+	}
+	if ((first && size >= 9 && memcmp(buf, "VimCrypt~", 9) == 0)
+		|| memchr(buf + keep, NUL, (size_t)size) != NULL)
+	{
+	    found = TRUE;
+	    break;
+	}
+	first = FALSE;
+	size += keep;
+	if (vgr_find_text(buf, size, text, len, ic))
+	{
+	    found = TRUE;
+	    break;
+	}
+	/* The text may start at the end of this block. */
+	keep = size < len - 1 ? size : len - 1;
+	mch_memmove(buf, buf + size - keep, (size_t)keep);
+    }
+    vim_free(buf);
+    close(fd);
+    return found;
+}
+
+/*
+ * Return TRUE if "text", "len" bytes, appears in "buf", "buflen" bytes
+ * without a NUL.
+ */
+    static int
+vgr_find_text(char_u *buf, long buflen, char_u *text, int len, int ic)
+{
+    long	i;
+    int		j;
+    char_u	*p;
+
+    if (!ic)
+    {
+	for (i = 0; i + len <= buflen; i = (long)(p - buf) + 1)
+	{
+	    p = memchr(buf + i, text[0], (size_t)(buflen - len - i + 1));
+	    if (p == NULL)
+		break;
+	    if (memcmp(p, text, (size_t)len) == 0)
+		return TRUE;
+	}
+    }
+    else
+	for (i = 0; i + len <= buflen; ++i)
+	{
+	    for (j = 0; j < len; ++j)
+		if (TOLOWER_ASC(buf[i + j]) != TOLOWER_ASC(text[j]))
+		    break;
+	    if (j == len)
+		return TRUE;
+	}
+    return FALSE;
+}
+
 /*
  * Load file "fname" into a dummy buffer and return the buffer pointer,
  * placing the directory resulting from the buffer load into the
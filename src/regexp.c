@@ -55,6 +55,11 @@
 # define BT_REGEXP_DEBUG_LOG_NAME	"bt_regexp_debug.log"
 #endif
 
+#if defined(FEAT_PROFILE) && defined(FEAT_FLOAT)
+/* measure the time used by patterns for the automatic engine */
+# define REGEXP_STATS
+#endif
+
 /*
  * The "internal use only" fields in regexp.h are present to pass info from
  * compile to execute that permits the execute phase to run lots faster on
@@ -65,16 +70,18 @@
  * reganch	is the match anchored (at beginning-of-line only)?
  * regmust	string (pointer into program) that match must include, or NULL
  * regmlen	length of regmust string
+ * regmoff	offset of the byte in regmust that is searched for
  * regflags	RF_ values or'ed together
  *
  * Regstart and reganch permit very fast decisions on suitable starting points
  * for a match, cutting down the work a lot.  Regmust permits fast rejection
  * of lines that cannot possibly match.  The regmust tests are costly enough
  * that vim_regcomp() supplies a regmust only if the r.e. contains something
- * potentially expensive (at present, the only such thing detected is * or +
- * at the start of the r.e., which can involve a lot of backup).  Regmlen is
+ * potentially expensive (at present, * or + at the start of the r.e., which
+ * can involve a lot of backup) or when there is no regstart.  Regmlen is
  * supplied because the test in vim_regexec() needs it and vim_regcomp() is
- * computing it anyway.
+ * computing it anyway.  Regmoff is the least common byte in regmust, it is
+ * searched for first.
  */
 
 /*
@@ -345,6 +352,10 @@ toggle_Magic(int x)
 static int re_multi_type(int);
 static int cstrncmp(char_u *s1, char_u *s2, int *n);
 static char_u *cstrchr(char_u *, int);
+static int byte_rarity(int c);
+#ifdef FEAT_MBYTE
+static int ascii_has_mb_fold(int c);
+#endif
 
 #ifdef BT_REGEXP_DUMP
 static void	regdump(char_u *, bt_regprog_T *);
@@ -722,6 +733,12 @@ static char_u	*re_put_long(char_u *pr, long_u val);
 static int	read_limits(long *, long *);
 static void	regtail(char_u *, char_u *);
 static void	regoptail(char_u *, char_u *);
+static linenr_T	re_lines_add(linenr_T a, linenr_T b);
+static linenr_T	re_lines_alt(void);
+static linenr_T	re_lines_concat(void);
+static linenr_T	re_lines_piece(void);
+static linenr_T	re_lines_atom(void);
+static linenr_T	re_lines_count(char_u *expr, int re_flags);
 
 static regengine_T bt_regengine;
 static regengine_T nfa_regengine;
@@ -745,6 +762,281 @@ re_lookbehind(regprog_T *prog)
     return (prog->regflags & RF_LOOKBH);
 }
 
+/*
+ * Return the maximum number of line breaks a match of compiled regular
+ * expression "prog" can span, including what a look-ahead inspects.  Zero
+ * for a pattern that only ever looks at one line, MAXLNUM when there is no
+ * limit.
+ */
+    linenr_T
+re_maxlines(regprog_T *prog)
+{
+    return prog->re_maxlines;
+}
+
+/*
+ * Functions to compute re_maxlines() from the pattern text.  They use the
+ * same lexer as the compiler, but only look at what can match a line break.
+ * The result may be too big, never too small.
+ */
+static int	re_lines_nl;	/* TRUE when an item spanning lines was seen */
+
+    static linenr_T
+re_lines_add(linenr_T a, linenr_T b)
+{
+    if (a >= MAXLNUM - b)
+	return MAXLNUM;
+    return a + b;
+}
+
+/*
+ * Alternatives "a\|b" and "a\&b", up to the end of the pattern or a ")".
+ */
+    static linenr_T
+re_lines_alt(void)
+{
+    linenr_T	n;
+    linenr_T	max = 0;
+
+    for (;;)
+    {
+	n = re_lines_concat();
+	if (n > max)
+	    max = n;
+	if (peekchr() != Magic('|') && peekchr() != Magic('&'))
+	    break;
+	skipchr();
+    }
+    return max;
+}
+
+/*
+ * A sequence of pieces: the line breaks add up.
+ */
+    static linenr_T
+re_lines_concat(void)
+{
+    linenr_T	n = 0;
+
+    for (;;)
+    {
+	switch (peekchr())
+	{
+	    case NUL:
+	    case Magic('|'):
+	    case Magic('&'):
+	    case Magic(')'):
+			    return n;
+	    case Magic('Z'):
+	    case Magic('c'):
+	    case Magic('C'):
+			    skipchr_keepstart();
+			    break;
+	    case Magic('v'):
+			    reg_magic = MAGIC_ALL;
+			    skipchr_keepstart();
+			    curchr = -1;
+			    break;
+	    case Magic('m'):
+			    reg_magic = MAGIC_ON;
+			    skipchr_keepstart();
+			    curchr = -1;
+			    break;
+	    case Magic('M'):
+			    reg_magic = MAGIC_OFF;
+			    skipchr_keepstart();
+			    curchr = -1;
+			    break;
+	    case Magic('V'):
+			    reg_magic = MAGIC_NONE;
+			    skipchr_keepstart();
+			    curchr = -1;
+			    break;
+	    default:
+			    n = re_lines_add(n, re_lines_piece());
+			    break;
+	}
+    }
+}
+
+/*
+ * An atom with an optional multi.
+ */
+    static linenr_T
+re_lines_piece(void)
+{
+    linenr_T	n;
+    int		op;
+    long	minval;
+    long	maxval;
+
+    n = re_lines_atom();
+    if (n > 0)
+	re_lines_nl = TRUE;
+    op = peekchr();
+    if (re_multi_type(op) == NOT_MULTI)
+	return n;
+    skipchr();
+    switch (op)
+    {
+	case Magic('*'):
+	case Magic('+'):
+	    return n > 0 ? MAXLNUM : 0;
+
+	case Magic('@'):
+	    (void)getdecchrs();
+	    if (no_Magic(getchr()) == '<')
+	    {
+		/* Look-behind with a line break can look at any line above. */
+		(void)getchr();
+		return n > 0 ? MAXLNUM : 0;
+	    }
+	    return n;
+
+	case Magic('{'):
+	    if (!read_limits(&minval, &maxval))
+		return MAXLNUM;
+	    if (n == 0)
+		return 0;
+	    if (minval > maxval)
+		maxval = minval;
+	    if (maxval >= MAX_LIMIT || maxval >= MAXLNUM / n)
+		return MAXLNUM;
+	    return n * maxval;
+    }
+    return n;	    /* "\=" and "\?" */
+}
+
+/*
+ * The smallest item, see regatom().
+ */
+    static linenr_T
+re_lines_atom(void)
+{
+    linenr_T	n = 0;
+    char_u	*lp;
+    char_u	*p;
+    int		c;
+
+    c = getchr();
+    switch (c)
+    {
+	case Magic('n'):
+	    return reg_string ? 0 : 1;
+
+	case Magic('_'):
+	    c = no_Magic(getchr());
+	    if (c == '^' || c == '$')
+		return 0;
+	    if (c != '[')
+		return 1;	/* "\_x" */
+	    n = 1;
+	    /*FALLTHROUGH*/
+
+	case Magic('['):
+	    lp = skip_anyof(regparse);
+	    if (*lp != ']')
+		return n;	/* literal '[' */
+	    for (p = regparse; p < lp; ++p)
+		if (p[0] == '\\' && p[1] == 'n')
+		    n = 1;	/* "[a\n]" */
+	    regparse = lp;
+	    skipchr();
+	    return reg_string ? 0 : n;
+
+	case Magic('('):
+	    break;
+
+	case Magic('%'):
+	    c = no_Magic(getchr());
+	    if (c == '(')
+		break;
+	    if (c == '[')
+	    {
+		/* "\%[abc]": every item is optional */
+		while ((c = getchr()) != ']')
+		{
+		    if (c == NUL)
+			return MAXLNUM;
+		    ungetchr();
+		    n = re_lines_add(n, re_lines_atom());
+		}
+		return n;
+	    }
+	    if (c == 'd')
+		(void)getdecchrs();
+	    else if (c == 'o')
+		(void)getoctchrs();
+	    else if (c == 'x')
+		(void)gethexchrs(2);
+	    else if (c == 'u')
+		(void)gethexchrs(4);
+	    else if (c == 'U')
+		(void)gethexchrs(8);
+	    else if (VIM_ISDIGIT(c) || c == '<' || c == '>' || c == '\'')
+	    {
+		/* "\%23l", "\%<'m", etc. */
+		if (c == '<' || c == '>')
+		    c = getchr();
+		while (VIM_ISDIGIT(c))
+		    c = getchr();
+		if (c == '\'')
+		    (void)getchr();
+	    }
+	    return 0;
+
+	case Magic('z'):
+	    c = no_Magic(getchr());
+	    if (c == '(')
+		break;
+	    /* "\z1": the external match may contain line breaks */
+	    return VIM_ISDIGIT(c) ? MAXLNUM : 0;
+
+	case Magic('1'):
+	case Magic('2'):
+	case Magic('3'):
+	case Magic('4'):
+	case Magic('5'):
+	case Magic('6'):
+	case Magic('7'):
+	case Magic('8'):
+	case Magic('9'):
+	    return re_lines_nl ? MAXLNUM : 0;
+
+	default:
+	    return 0;
+    }
+
+    /* A group "\(\)", "\%(\)" or "\z(\)". */
+    n = re_lines_alt();
+    if (peekchr() == Magic(')'))
+	skipchr();
+    return n;
+}
+
+/*
+ * Compute the value for re_maxlines() for pattern "expr".  Must be called
+ * after successfully compiling "expr".
+ */
+    static linenr_T
+re_lines_count(char_u *expr, int re_flags)
+{
+    linenr_T	n;
+#if defined(FEAT_SYN_HL) || defined(PROTO)
+    int		save_had_eol = had_eol;
+#endif
+
+    regcomp_start(expr, re_flags);
+    re_lines_nl = FALSE;
+    n = re_lines_alt();
+    if (peekchr() != NUL)
+	n = MAXLNUM;	/* unmatched ")", cannot happen */
+#if defined(FEAT_SYN_HL) || defined(PROTO)
+    had_eol = save_had_eol;
+#endif
+    return n;
+}
+
 /*
  * Check for an equivalence class name "[=a=]".  "pp" points to the '['.
  * Returns a character representing the class. Zero means that no item was
@@ -1320,6 +1612,7 @@ bt_regcomp(char_u *expr, int re_flags)
     char_u	*longest;
     int		len;
     int		flags;
+    int		i;
 
     if (expr == NULL)
 	EMSG_RET_NULL(_(e_null));
@@ -1359,6 +1652,7 @@ bt_regcomp(char_u *expr, int re_flags)
     r->reganch = 0;
     r->regmust = NULL;
     r->regmlen = 0;
+    r->regmoff = 0;
     r->regflags = regflags;
     if (flags & HASNL)
 	r->regflags |= RF_HASNL;
@@ -1415,8 +1709,11 @@ bt_regcomp(char_u *expr, int re_flags)
 	/*
 	 * When the r.e. starts with BOW, it is faster to look for a regmust
 	 * first. Used a lot for "#" and "*" commands. (Added by mool).
+	 * Also when there is no regstart, finding the regmust is fast and
+	 * skips lines that can't match.
 	 */
-	if ((flags & SPSTART || OP(scan) == BOW || OP(scan) == EOW)
+	if ((flags & SPSTART || OP(scan) == BOW || OP(scan) == EOW
+						       || r->regstart == NUL)
 							  && !(flags & HASNL))
 	{
 	    longest = NULL;
@@ -1429,6 +1726,12 @@ bt_regcomp(char_u *expr, int re_flags)
 		}
 	    r->regmust = longest;
 	    r->regmlen = len;
+
+	    /* Search for the byte that is least likely to appear in the text,
+	     * that skips over more text. */
+	    for (i = 1; i < len; ++i)
+		if (byte_rarity(longest[i]) > byte_rarity(longest[r->regmoff]))
+		    r->regmoff = i;
 	}
     }
 #ifdef BT_REGEXP_DUMP
@@ -3651,6 +3954,12 @@ static garray_T	backpos = {0, 0, 0, 0, NULL};
 #define BACKPOS_INITIAL		64
 
 #if defined(EXITFREE) || defined(PROTO)
+static void nfa_free_spare_lists(void);
+static void regcache_clear(void);
+# ifdef REGEXP_STATS
+static void regstat_clear(void);
+# endif
+
     void
 free_regexp_stuff(void)
 {
@@ -3658,6 +3967,11 @@ free_regexp_stuff(void)
     ga_clear(&backpos);
     vim_free(reg_tofree);
     vim_free(reg_prev_sub);
+    nfa_free_spare_lists();
+    regcache_clear();
+# ifdef REGEXP_STATS
+    regstat_clear();
+# endif
 }
 #endif
 
@@ -3852,15 +4166,24 @@ bt_regexec_both(
 	 */
 	if (!ireg_ic
 #ifdef FEAT_MBYTE
-		&& !has_mbyte
+		&& !ireg_icombine
 #endif
 		)
-	    while ((s = vim_strbyte(s, c)) != NULL)
+	{
+	    char_u  *p = s;
+	    int	    off = prog->regmoff;
+
+	    /* Find the least common byte, then compare the whole string.
+	     * Comparing bytes works, regmust starts with a whole character. */
+	    while ((p = vim_strbyte(p, prog->regmust[off])) != NULL)
 	    {
-		if (cstrncmp(s, prog->regmust, &prog->regmlen) == 0)
+		if (p - off >= s && STRNCMP(p - off, prog->regmust,
+							  prog->regmlen) == 0)
 		    break;		/* Found it. */
-		++s;
+		++p;
 	    }
+	    s = p == NULL ? NULL : p - off;
+	}
 #ifdef FEAT_MBYTE
 	else if (!ireg_ic || (!enc_utf8 && mb_char2len(c) > 1))
 	    while ((s = vim_strchr(s, c)) != NULL)
@@ -7094,6 +7417,39 @@ cstrncmp(char_u *s1, char_u *s2, int *n)
     return result;
 }
 
+/*
+ * Return a number that is bigger for a byte that is less likely to appear in
+ * text.  Used to pick the byte to search for.
+ */
+    static int
+byte_rarity(int c)
+{
+    /* Most often used first, roughly for English text and program code. */
+    static char *common = " etaoinsrlhdcu\tmpfgywb.,_()=;vk-\"'x/0*1:2q>jz";
+    char    *p;
+
+    if (c <= 0 || c >= 0x80)
+	return 0;
+    p = strchr(common, TOLOWER_ASC(c));
+    if (p == NULL)
+	return 100;
+    /* An upper case letter is less common than a lower case one. */
+    return (int)(p - common) + (ASCII_ISUPPER(c) ? 20 : 0);
+}
+
+#ifdef FEAT_MBYTE
+/*
+ * Return TRUE when ASCII character "c" can match a non-ASCII character when
+ * ignoring case: the Kelvin sign, long s and I with dot above fold to "k", "s"
+ * and "i".  Looking for "c" and its other case may then miss a match.
+ */
+    static int
+ascii_has_mb_fold(int c)
+{
+    return enc_utf8 && vim_strchr((char_u *)"iIkKsS", c) != NULL;
+}
+#endif
+
 /*
  * cstrchr: This function is used a lot for simple searches, keep it fast!
  */
@@ -7125,6 +7481,24 @@ cstrchr(char_u *s, int c)
     else
 	return vim_strchr(s, c);
 
+    /* Two bytes can be found with strpbrk(), which is usually much faster
+     * than a loop.  With UTF-8 only for ASCII, with a double-byte encoding
+     * a trail byte may match. */
+#ifdef FEAT_MBYTE
+    if (has_mbyte ? enc_utf8 && c < 0x80 && cc < 0x80
+		  : c < 0x100 && cc < 0x100)
+#else
+    if (c < 0x100 && cc < 0x100)
+#endif
+    {
+	char_u	both[3];
+
+	both[0] = c;
+	both[1] = cc;
+	both[2] = NUL;
+	return vim_strpbrk(s, both);
+    }
+
 #ifdef FEAT_MBYTE
     if (has_mbyte)
     {
@@ -8040,6 +8414,570 @@ static char_u regname[][30] = {
 			    };
 #endif
 
+/*
+ * Cache of compiled patterns.  Plugins and syntax highlighting often compile
+ * the same pattern many times, e.g. with match() and substitute().  A
+ * program found in the cache is shared, "re_refcount" counts the users,
+ * including the cache.  The least recently used entry is dropped when the
+ * cache is full.
+ */
+#define REGCACHE_SIZE	32
+
+/* Things other than the pattern and flags that matter for compiling. */
+#define RC_CPO_LIT	0x01	/* 'l' in 'cpoptions' */
+#define RC_CPO_BSL	0x02	/* '\' in 'cpoptions' */
+#define RC_UTF8		0x04	/* 'encoding' is UTF-8 */
+#define RC_MBYTE	0x08	/* 'encoding' is multi-byte */
+#define RC_EXTMATCH	0x10	/* times value of reg_do_extmatch */
+
+typedef struct
+{
+    char_u	*rc_pat;	/* pattern as passed to vim_regcomp() */
+    int		rc_flags;	/* "re_flags" argument */
+    int		rc_engine;	/* value of 'regexpengine' */
+    int		rc_env;		/* RC_ flags */
+    int		rc_had_eol;	/* value of "had_eol" after compiling */
+    regprog_T	*rc_prog;	/* compiled program */
+    long	rc_hits;	/* times found in the cache */
+    long	rc_last_used;	/* value of regcache_clock when last used */
+} regcache_T;
+
+static regcache_T   regcache[REGCACHE_SIZE];
+static int	    regcache_len = 0;	    /* used entries in regcache[] */
+static long	    regcache_clock = 0;
+static long	    regcache_hit_count = 0;
+static long	    regcache_miss_count = 0;
+
+static int regcache_env(void);
+static regprog_T *regcache_find(char_u *pat, int re_flags, int env);
+static void regcache_add(char_u *pat, int re_flags, int env, regprog_T *prog);
+static void regcache_clear(void);
+
+/*
+ * Return the RC_ flags for the current option values.
+ */
+    static int
+regcache_env(void)
+{
+    int env = 0;
+
+    if (vim_strchr(p_cpo, CPO_LITERAL) != NULL)
+	env |= RC_CPO_LIT;
+    if (vim_strchr(p_cpo, CPO_BACKSL) != NULL)
+	env |= RC_CPO_BSL;
+#ifdef FEAT_MBYTE
+    if (enc_utf8)
+	env |= RC_UTF8;
+    if (has_mbyte)
+	env |= RC_MBYTE;
+    /* Double-byte encodings differ in the lead bytes. */
+    env |= enc_dbcs << 8;
+#endif
+#ifdef FEAT_SYN_HL
+    env |= reg_do_extmatch * RC_EXTMATCH;
+#endif
+    return env;
+}
+
+/*
+ * Find a compiled program for "pat" in the cache.  If found return it with
+ * its reference count incremented, otherwise return NULL.
+ */
+    static regprog_T *
+regcache_find(char_u *pat, int re_flags, int env)
+{
+    int		i;
+    regcache_T	*rc;
+
+    for (i = 0; i < regcache_len; ++i)
+    {
+	rc = &regcache[i];
+	if (rc->rc_flags == re_flags && rc->rc_engine == p_re
+		&& rc->rc_env == env && STRCMP(rc->rc_pat, pat) == 0)
+	{
+	    ++rc->rc_hits;
+	    ++regcache_hit_count;
+	    rc->rc_last_used = ++regcache_clock;
+	    had_eol = rc->rc_had_eol;
+	    ++rc->rc_prog->re_refcount;
+	    return rc->rc_prog;
+	}
+    }
+    ++regcache_miss_count;
+    return NULL;
+}
+
+/*
+ * Add compiled program "prog" for "pat" to the cache, dropping the least
+ * recently used entry when the cache is full.
+ */
+    static void
+regcache_add(char_u *pat, int re_flags, int env, regprog_T *prog)
+{
+    int		i;
+    regcache_T	*rc;
+    char_u	*p;
+
+    p = vim_strsave(pat);
+    if (p == NULL)
+	return;
+    if (regcache_len < REGCACHE_SIZE)
+	rc = &regcache[regcache_len++];
+    else
+    {
+	rc = &regcache[0];
+	for (i = 1; i < REGCACHE_SIZE; ++i)
+	    if (regcache[i].rc_last_used < rc->rc_last_used)
+		rc = &regcache[i];
+	vim_free(rc->rc_pat);
+	vim_regfree(rc->rc_prog);
+    }
+    rc->rc_pat = p;
+    rc->rc_flags = re_flags;
+    rc->rc_engine = p_re;
+    rc->rc_env = env;
+    rc->rc_had_eol = had_eol;
+    rc->rc_prog = prog;
+    rc->rc_hits = 0;
+    rc->rc_last_used = ++regcache_clock;
+    ++prog->re_refcount;
+}
+
+/*
+ * Drop all entries from the cache.  A program that is still in use is freed
+ * when its last user is done with it.
+ */
+    static void
+regcache_clear(void)
+{
+    int		i;
+
+    for (i = 0; i < regcache_len; ++i)
+    {
+	vim_free(regcache[i].rc_pat);
+	vim_regfree(regcache[i].rc_prog);
+    }
+    regcache_len = 0;
+}
+
+/*
+ * ":regexpcache": list the patterns in the cache of compiled patterns.
+ * ":regexpcache clear": empty the cache and reset the counters.
+ */
+    void
+ex_regexpcache(exarg_T *eap)
+{
+    int		i;
+    regcache_T	*rc;
+    char	lines[20];
+
+    if (STRCMP(eap->arg, "clear") == 0)
+    {
+	regcache_clear();
+	regcache_hit_count = 0;
+	regcache_miss_count = 0;
+	return;
+    }
+    if (*eap->arg != NUL)
+    {
+	EMSG2(_(e_invarg2), eap->arg);
+	return;
+    }
+
+    MSG_PUTS_TITLE(_("\n    HITS  USERS ENGINE LINES PATTERN"));
+    for (i = 0; i < regcache_len && !got_int; ++i)
+    {
+	rc = &regcache[i];
+	msg_putchar('\n');
+	if (rc->rc_prog->re_maxlines == MAXLNUM)
+	    STRCPY(lines, "-");
+	else
+	    sprintf(lines, "%ld", (long)rc->rc_prog->re_maxlines);
+	vim_snprintf((char *)IObuff, IOSIZE, "%8ld %6d %-6s %5s ",
+		rc->rc_hits, rc->rc_prog->re_refcount - 1,
+		rc->rc_prog->re_engine == BACKTRACKING_ENGINE ? "bt" : "nfa",
+		lines);
+	msg_puts(IObuff);
+	msg_outtrans(rc->rc_pat);
+	out_flush();
+	ui_breakcheck();
+    }
+    msg_putchar('\n');
+    vim_snprintf((char *)IObuff, IOSIZE,
+	    _("%d patterns, %ld found in the cache, %ld compiled"),
+	    regcache_len, regcache_hit_count, regcache_miss_count);
+    msg_puts(IObuff);
+}
+
+#ifdef REGEXP_STATS
+/*
+ * Timing of patterns compiled for the automatic engine ('regexpengine' is
+ * zero).  The time spent matching each pattern is measured.  When the NFA
+ * engine is slow for a pattern, the backtracking engine is tried for a number
+ * of calls.  The faster one is then used for that pattern for the rest of the
+ * session.  A program points to the regstat_T of its pattern, thus programs
+ * found in the cache and compiled again share it.
+ */
+# define REGSTAT_MAX	1000	/* max number of patterns measured */
+# define RS_TRY_CALLS	20	/* number of calls to measure an engine */
+# define RS_TRY_TIME	0.1	/* or the time in seconds to measure it */
+# define RS_SLOW_TIME	0.00002	/* average NFA time in seconds that makes
+				   it worth trying the other engine */
+
+/* Values for rs_state */
+# define RS_MEASURE	0	/* measuring the NFA engine */
+# define RS_TRY_BT	1	/* trying the backtracking engine */
+# define RS_DECIDED	2	/* using "rs_engine" from now on */
+
+struct regstat_S
+{
+    regstat_T	*rs_next;	/* same pattern, other flags or options */
+    int		rs_flags;	/* "re_flags" argument */
+    int		rs_env;		/* RC_ flags */
+    int		rs_state;	/* RS_ value */
+    int		rs_engine;	/* NFA_ENGINE or BACKTRACKING_ENGINE */
+    int		rs_bt_failed;	/* could not compile "rs_bt" */
+    regprog_T	*rs_bt;		/* program for the backtracking engine */
+    long	rs_count[3];	/* number of calls, indexed by engine */
+    float_T	rs_time[3];	/* seconds spent, indexed by engine */
+    char_u	rs_pat[1];	/* pattern, actually longer; used as hashtab
+				   key */
+};
+
+/*
+ * In a hashtable item "hi_key" points to "rs_pat" in a regstat_T.
+ */
+static regstat_T dumstat;
+# define HIKEY2RS(p)	((regstat_T *)((p) - (dumstat.rs_pat - (char_u *)&dumstat)))
+# define HI2RS(hi)	HIKEY2RS((hi)->hi_key)
+
+static hashtab_T    regstat_ht;
+static int	    regstat_ht_init = FALSE;
+static int	    regstat_len = 0;	/* number of patterns in regstat_ht */
+
+static regstat_T *regstat_find(char_u *pat, int re_flags, int env);
+static regprog_T *regstat_prog(regstat_T *rs, regprog_T *prog);
+static int regstat_add(regstat_T *rs, regprog_T *used, proftime_T *tm, int result);
+static void regstat_reset(regstat_T *rs);
+# if defined(EXITFREE) || defined(PROTO)
+static void regstat_clear(void);
+# endif
+static int regstat_compare(const void *s1, const void *s2);
+
+/*
+ * Find the regstat_T for "pat" compiled with "re_flags" and "env".  Add one
+ * when not found.  Returns NULL when out of memory or when too many patterns
+ * were measured already.
+ */
+    static regstat_T *
+regstat_find(char_u *pat, int re_flags, int env)
+{
+    hash_T	hash;
+    hashitem_T	*hi;
+    regstat_T	*rs;
+
+    if (!regstat_ht_init)
+    {
+	hash_init(&regstat_ht);
+	regstat_ht_init = TRUE;
+    }
+    hash = hash_hash(pat);
+    hi = hash_lookup(&regstat_ht, pat, hash);
+    if (!HASHITEM_EMPTY(hi))
+	for (rs = HI2RS(hi); rs != NULL; rs = rs->rs_next)
+	    if (rs->rs_flags == re_flags && rs->rs_env == env)
+		return rs;
+
+    if (regstat_len >= REGSTAT_MAX)
+	return NULL;
+    rs = (regstat_T *)alloc_clear(
+				 (unsigned)(sizeof(regstat_T) + STRLEN(pat)));
+    if (rs == NULL)
+	return NULL;
+    STRCPY(rs->rs_pat, pat);
+    rs->rs_flags = re_flags;
+    rs->rs_env = env;
+    regstat_reset(rs);
+    if (HASHITEM_EMPTY(hi))
+    {
+	if (hash_add_item(&regstat_ht, hi, rs->rs_pat, hash) == FAIL)
+	{
+	    vim_free(rs);
+	    return NULL;
+	}
+    }
+    else
+    {
+	/* Insert after the first one, the key must stay the same. */
+	rs->rs_next = HI2RS(hi)->rs_next;
+	HI2RS(hi)->rs_next = rs;
+    }
+    ++regstat_len;
+    return rs;
+}
+
+/*
+ * Return the program to use for matching with "prog", which was compiled by
+ * the NFA engine for the automatic engine.
+ */
+    static regprog_T *
+regstat_prog(regstat_T *rs, regprog_T *prog)
+{
+    if (rs->rs_engine != BACKTRACKING_ENGINE)
+	return prog;
+    if (rs->rs_bt == NULL)
+    {
+	/* Options may have changed since the pattern was compiled. */
+	if (regcache_env() != rs->rs_env)
+	    return prog;
+	bt_regengine.expr = rs->rs_pat;
+	rs->rs_bt = bt_regengine.regcomp(rs->rs_pat, rs->rs_flags);
+	if (rs->rs_bt == NULL)
+	{
+	    rs->rs_bt_failed = TRUE;
+	    rs->rs_engine = NFA_ENGINE;
+	    rs->rs_state = RS_DECIDED;
+	    return prog;
+	}
+	rs->rs_bt->re_engine = BACKTRACKING_ENGINE;
+	rs->rs_bt->re_flags = rs->rs_flags;
+	rs->rs_bt->re_refcount = 1;
+	rs->rs_bt->re_stat = NULL;
+	rs->rs_bt->re_maxlines = prog->re_maxlines;
+    }
+    return rs->rs_bt;
+}
+
+/*
+ * Add the time "tm" of a call to program "used" with "result" to "rs".
+ * "tm" is NULL when the call was not measured, because the engine was
+ * already decided.
+ * Decides what engine to use when enough calls were measured.
+ * Returns TRUE when the NFA engine gave up and the backtracking engine is to
+ * be used instead.
+ */
+    static int
+regstat_add(regstat_T *rs, regprog_T *used, proftime_T *tm, int result)
+{
+    int		engine = used->re_engine == BACKTRACKING_ENGINE
+					    ? BACKTRACKING_ENGINE : NFA_ENGINE;
+    float_T	nfa_avg;
+    float_T	bt_avg;
+
+    if (tm != NULL)
+    {
+	++rs->rs_count[engine];
+	rs->rs_time[engine] += profile_float(tm);
+    }
+
+    if (engine == NFA_ENGINE && result == NFA_TOO_EXPENSIVE)
+    {
+	if (rs->rs_bt_failed)
+	    return FALSE;
+	rs->rs_engine = BACKTRACKING_ENGINE;
+	rs->rs_state = RS_DECIDED;
+	return TRUE;
+    }
+
+    if (rs->rs_state == RS_MEASURE
+	    && (rs->rs_count[NFA_ENGINE] >= RS_TRY_CALLS
+				     || rs->rs_time[NFA_ENGINE] >= RS_TRY_TIME))
+    {
+	nfa_avg = rs->rs_time[NFA_ENGINE] / rs->rs_count[NFA_ENGINE];
+	if (nfa_avg < RS_SLOW_TIME || rs->rs_bt_failed)
+	    rs->rs_state = RS_DECIDED;
+	else
+	{
+	    rs->rs_state = RS_TRY_BT;
+	    rs->rs_engine = BACKTRACKING_ENGINE;
+	}
+    }
+    else if (rs->rs_state == RS_TRY_BT
+	    && (rs->rs_count[BACKTRACKING_ENGINE] >= RS_TRY_CALLS
+			    || rs->rs_time[BACKTRACKING_ENGINE] >= RS_TRY_TIME))
+    {
+	nfa_avg = rs->rs_time[NFA_ENGINE] / rs->rs_count[NFA_ENGINE];
+	bt_avg = rs->rs_time[BACKTRACKING_ENGINE]
+					   / rs->rs_count[BACKTRACKING_ENGINE];
+	rs->rs_state = RS_DECIDED;
+	if (bt_avg >= nfa_avg)
+	{
+	    rs->rs_engine = NFA_ENGINE;
+	    vim_regfree(rs->rs_bt);
+	    rs->rs_bt = NULL;
+	}
+	else if (p_verbose > 0)
+	{
+	    verbose_enter();
+	    smsg((char_u *)_("Using backtracking RE engine for pattern: %s"),
+								  rs->rs_pat);
+	    verbose_leave();
+	}
+    }
+    return FALSE;
+}
+
+/*
+ * Start measuring "rs" again.
+ */
+    static void
+regstat_reset(regstat_T *rs)
+{
+    int		i;
+
+    for (i = 0; i < 3; ++i)
+    {
+	rs->rs_count[i] = 0;
+	rs->rs_time[i] = 0;
+    }
+    rs->rs_state = RS_MEASURE;
+    rs->rs_engine = NFA_ENGINE;
+    rs->rs_bt_failed = FALSE;
+    vim_regfree(rs->rs_bt);
+    rs->rs_bt = NULL;
+}
+
+# if defined(EXITFREE) || defined(PROTO)
+/*
+ * Free all the regstat_T.  Only to be used when no program is left.
+ */
+    static void
+regstat_clear(void)
+{
+    long	todo;
+    hashitem_T	*hi;
+    regstat_T	*rs;
+    regstat_T	*rs_next;
+
+    if (!regstat_ht_init)
+	return;
+    todo = (long)regstat_ht.ht_used;
+    for (hi = regstat_ht.ht_array; todo > 0; ++hi)
+	if (!HASHITEM_EMPTY(hi))
+	{
+	    --todo;
+	    for (rs = HI2RS(hi); rs != NULL; rs = rs_next)
+	    {
+		rs_next = rs->rs_next;
+		vim_regfree(rs->rs_bt);
+		vim_free(rs);
+	    }
+	}
+    hash_clear(&regstat_ht);
+    regstat_ht_init = FALSE;
+    regstat_len = 0;
+}
+# endif
+
+/*
+ * Sort on total time, longest first.
+ */
+    static int
+#ifdef __BORLANDC__
+_RTLENTRYF
+#endif
+regstat_compare(const void *s1, const void *s2)
+{
+    regstat_T	*rs1 = *(regstat_T **)s1;
+    regstat_T	*rs2 = *(regstat_T **)s2;
+    float_T	t1 = rs1->rs_time[NFA_ENGINE] + rs1->rs_time[BACKTRACKING_ENGINE];
+    float_T	t2 = rs2->rs_time[NFA_ENGINE] + rs2->rs_time[BACKTRACKING_ENGINE];
+
+    return t1 > t2 ? -1 : t1 < t2 ? 1 : 0;
+}
+#endif
+
+#if defined(REGEXP_STATS) || defined(PROTO)
+/*
+ * ":regexpstats": list the patterns that use the automatic engine, the ones
+ * that took the most time first.
+ * ":regexpstats clear": reset the counters and decide on the engine again.
+ */
+    void
+ex_regexpstats(exarg_T *eap)
+{
+    long	todo;
+    hashitem_T	*hi;
+    regstat_T	*rs;
+    garray_T	ga;
+    int		i;
+    int		e;
+    char	avg[3][20];
+    int		bt_count = 0;
+
+    if (STRCMP(eap->arg, "clear") == 0)
+    {
+	if (regstat_ht_init)
+	{
+	    todo = (long)regstat_ht.ht_used;
+	    for (hi = regstat_ht.ht_array; todo > 0; ++hi)
+		if (!HASHITEM_EMPTY(hi))
+		{
+		    --todo;
+		    for (rs = HI2RS(hi); rs != NULL; rs = rs->rs_next)
+			regstat_reset(rs);
+		}
+	}
+	return;
+    }
+    if (*eap->arg != NUL)
+    {
+	EMSG2(_(e_invarg2), eap->arg);
+	return;
+    }
+
+    ga_init2(&ga, (int)sizeof(regstat_T *), 50);
+    if (regstat_ht_init)
+    {
+	todo = (long)regstat_ht.ht_used;
+	for (hi = regstat_ht.ht_array; todo > 0; ++hi)
+	    if (!HASHITEM_EMPTY(hi))
+	    {
+		--todo;
+		for (rs = HI2RS(hi); rs != NULL; rs = rs->rs_next)
+		    if (rs->rs_count[NFA_ENGINE]
+					 + rs->rs_count[BACKTRACKING_ENGINE] > 0
+			    && ga_grow(&ga, 1) == OK)
+			((regstat_T **)ga.ga_data)[ga.ga_len++] = rs;
+	    }
+    }
+    qsort(ga.ga_data, (size_t)ga.ga_len, sizeof(regstat_T *),
+							     regstat_compare);
+
+    MSG_PUTS_TITLE(_("\n     TOTAL    COUNT  NFA AVERAGE   BT AVERAGE ENGINE PATTERN"));
+    for (i = 0; i < ga.ga_len && !got_int; ++i)
+    {
+	rs = ((regstat_T **)ga.ga_data)[i];
+	for (e = BACKTRACKING_ENGINE; e <= NFA_ENGINE; ++e)
+	    if (rs->rs_count[e] == 0)
+		STRCPY(avg[e], "-");
+	    else
+		vim_snprintf(avg[e], sizeof(avg[e]), "%.6f",
+					      rs->rs_time[e] / rs->rs_count[e]);
+	if (rs->rs_engine == BACKTRACKING_ENGINE)
+	    ++bt_count;
+	msg_putchar('\n');
+	vim_snprintf((char *)IObuff, IOSIZE, "%10.6f %8ld %12s %12s %-6s ",
+		rs->rs_time[NFA_ENGINE] + rs->rs_time[BACKTRACKING_ENGINE],
+		rs->rs_count[NFA_ENGINE] + rs->rs_count[BACKTRACKING_ENGINE],
+		avg[NFA_ENGINE], avg[BACKTRACKING_ENGINE],
+		rs->rs_engine == BACKTRACKING_ENGINE
+			? (rs->rs_state == RS_DECIDED ? "bt" : "bt?")
+			: (rs->rs_state == RS_DECIDED ? "nfa" : "nfa?"));
+	msg_puts(IObuff);
+	msg_outtrans(rs->rs_pat);
+	out_flush();
+	ui_breakcheck();
+    }
+    msg_putchar('\n');
+    vim_snprintf((char *)IObuff, IOSIZE,
+	    _("%d patterns, %d use the backtracking engine"),
+							 ga.ga_len, bt_count);
+    msg_puts(IObuff);
+    ga_clear(&ga);
+}
+#endif
+
 /*
  * Compile a regular expression into internal code.
  * Returns the program in allocated memory.
@@ -8051,6 +8989,18 @@ vim_regcomp(char_u *expr_arg, int re_flags)
 {
     regprog_T   *prog = NULL;
     char_u	*expr = expr_arg;
+    int		env = regcache_env();
+    int		use_cache = TRUE;
+
+    /* A "~" may use the previous substitute string, it can't be cached. */
+    if (vim_strchr(expr_arg, '~') != NULL)
+	use_cache = FALSE;
+    else
+    {
+	prog = regcache_find(expr_arg, re_flags, env);
+	if (prog != NULL)
+	    return prog;
+    }
 
     regexp_engine = p_re;
 
@@ -8074,6 +9024,8 @@ vim_regcomp(char_u *expr_arg, int re_flags)
 	{
 	    EMSG(_("E864: \\%#= can only be followed by 0, 1, or 2. The automatic engine will be used "));
 	    regexp_engine = AUTOMATIC_ENGINE;
+	    /* give the error again next time */
+	    use_cache = FALSE;
 	}
     }
     bt_regengine.expr = expr;
@@ -8124,6 +9076,16 @@ vim_regcomp(char_u *expr_arg, int re_flags)
 	 * out to be very slow when executing it. */
 	prog->re_engine = regexp_engine;
 	prog->re_flags  = re_flags;
+	prog->re_refcount = 1;
+	prog->re_stat = NULL;
+	prog->re_maxlines = re_lines_count(expr, re_flags);
+#ifdef REGEXP_STATS
+	if (regexp_engine == AUTOMATIC_ENGINE)
+	    prog->re_stat = regstat_find(expr, re_flags, env);
+#endif
+
+	if (use_cache)
+	    regcache_add(expr_arg, re_flags, env, prog);
     }
 
     return prog;
@@ -8131,11 +9093,12 @@ vim_regcomp(char_u *expr_arg, int re_flags)
 
 /*
  * Free a compiled regexp program, returned by vim_regcomp().
+ * It is only freed when the cache and other users are done with it.
  */
     void
 vim_regfree(regprog_T *prog)
 {
-    if (prog != NULL)
+    if (prog != NULL && --prog->re_refcount <= 0)
 	prog->engine->regfree(prog);
 }
 
@@ -8173,7 +9136,40 @@ vim_regexec_both(
     colnr_T	col,    /* column to start looking for match */
     int		nl)
 {
-    int result = rmp->regprog->engine->regexec_nl(rmp, line, col, nl);
+    int result;
+
+#ifdef REGEXP_STATS
+    if (rmp->regprog->re_stat != NULL)
+    {
+	regprog_T   *prog = rmp->regprog;
+	proftime_T  tm;
+	int	    measure;
+	int	    again;
+
+	/* Measure the time until the engine is decided, the program may be
+	 * replaced with one for the backtracking engine. */
+	do
+	{
+	    rmp->regprog = regstat_prog(prog->re_stat, prog);
+	    measure = prog->re_stat->rs_state != RS_DECIDED;
+	    if (measure)
+		profile_start(&tm);
+	    result = rmp->regprog->engine->regexec_nl(rmp, line, col, nl);
+	    if (measure)
+		profile_end(&tm);
+	    again = regstat_add(prog->re_stat, rmp->regprog,
+						measure ? &tm : NULL, result);
+	    rmp->regprog = prog;
+# ifdef FEAT_EVAL
+	    if (again)
+		report_re_switch(prog->re_stat->rs_pat);
+# endif
+	} while (again);
+	return result > 0;
+    }
+#endif
+
+    result = rmp->regprog->engine->regexec_nl(rmp, line, col, nl);
 
     /* NFA engine aborted because it's very slow. */
     if (rmp->regprog->re_engine == AUTOMATIC_ENGINE
@@ -8264,7 +9260,39 @@ vim_regexec_multi(
     colnr_T     col,            /* column to start looking for match */
     proftime_T	*tm)		/* timeout limit or NULL */
 {
-    int result = rmp->regprog->engine->regexec_multi(
+    int result;
+
+#ifdef REGEXP_STATS
+    if (rmp->regprog->re_stat != NULL)
+    {
+	regprog_T   *prog = rmp->regprog;
+	proftime_T  stat_tm;
+	int	    measure;
+	int	    again;
+
+	do
+	{
+	    rmp->regprog = regstat_prog(prog->re_stat, prog);
+	    measure = prog->re_stat->rs_state != RS_DECIDED;
+	    if (measure)
+		profile_start(&stat_tm);
+	    result = rmp->regprog->engine->regexec_multi(
+						rmp, win, buf, lnum, col, tm);
+	    if (measure)
+		profile_end(&stat_tm);
+	    again = regstat_add(prog->re_stat, rmp->regprog,
+					    measure ? &stat_tm : NULL, result);
+	    rmp->regprog = prog;
+# ifdef FEAT_EVAL
+	    if (again)
+		report_re_switch(prog->re_stat->rs_pat);
+# endif
+	} while (again);
+	return result <= 0 ? 0 : result;
+    }
+#endif
+
+    result = rmp->regprog->engine->regexec_multi(
 						rmp, win, buf, lnum, col, tm);
 
     /* NFA engine aborted because it's very slow. */
@@ -8293,3 +9321,78 @@ vim_regexec_multi(
 
     return result <= 0 ? 0 : result;
 }
+
+#if defined(FEAT_QUICKFIX) || defined(FEAT_SYN_HL) || defined(PROTO)
+/*
+ * Get printable ASCII text that every match of "prog" contains.  Used to skip
+ * over files and lines that can't match without trying the pattern.
+ * The text is stored in "buf", at most "buflen - 1" bytes.  "*icp" is set to
+ * TRUE when the text must be found ignoring case, "ic" is the value of
+ * 'ignorecase' used for matching.
+ * Returns the length of the text, zero when there is none.
+ */
+    int
+vim_regmust_text(
+    regprog_T	*prog,
+    int		ic,
+    char_u	*buf,
+    int		buflen,
+    int		*icp)
+{
+    char_u	*text = NULL;
+    int		c = NUL;
+    int		len = 0;
+    int		i;
+
+    /* Combining characters in the text may be between the characters. */
+    if (prog->regflags & RF_ICOMBINE)
+	return 0;
+    *icp = (ic || (prog->regflags & RF_ICASE))
+					   && !(prog->regflags & RF_NOICASE);
+
+    if (prog->engine == &bt_regengine)
+    {
+	if (((bt_regprog_T *)prog)->regmust != NULL)
+	    text = ((bt_regprog_T *)prog)->regmust;
+	else
+	    c = ((bt_regprog_T *)prog)->regstart;
+    }
+    else
+    {
+	nfa_regprog_T *nprog = (nfa_regprog_T *)prog;
+
+	c = nprog->regstart;
+	if (c != NUL && c < 0x80 && nprog->match_text != NULL)
+	    text = nprog->match_text;
+	else if (nprog->must_char != NUL)
+	    c = nprog->must_char;
+    }
+
+    if (c != NUL)
+    {
+	if (c >= 0x80)
+	    return 0;
+	buf[len++] = c;
+    }
+    if (text != NULL)
+	for ( ; *text != NUL && len < buflen - 1; ++text)
+	{
+	    if (*text >= 0x80)
+		break;
+	    buf[len++] = *text;
+	}
+    buf[len] = NUL;
+
+    for (i = 0; i < len; ++i)
+    {
+	/* Only printable characters and Tab can be found as-is in the file. */
+	if ((buf[i] < ' ' && buf[i] != TAB) || buf[i] == DEL)
+	    return 0;
+#ifdef FEAT_MBYTE
+	if (*icp && ascii_has_mb_fold(buf[i]))
+	    return 0;
+#endif
+    }
+    return len;
+}
+#endif
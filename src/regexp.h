@@ -40,6 +40,7 @@
 #define	    NFA_ENGINE		2
 
 typedef struct regengine regengine_T;
+typedef struct regstat_S regstat_T;
 
 /*
  * Structure returned by vim_regcomp() to pass on to vim_regexec().
@@ -52,6 +53,9 @@ typedef struct regprog
     unsigned		regflags;
     unsigned		re_engine;   /* automatic, backtracking or nfa engine */
     unsigned		re_flags;    /* second argument for vim_regcomp() */
+    int			re_refcount; /* number of users, including the cache */
+    regstat_T		*re_stat;    /* timing for the automatic engine */
+    linenr_T		re_maxlines; /* see re_maxlines() */
 } regprog_T;
 
 /*
@@ -61,16 +65,20 @@ typedef struct regprog
  */
 typedef struct
 {
-    /* These four members implement regprog_T */
+    /* These seven members implement regprog_T */
     regengine_T		*engine;
     unsigned		regflags;
     unsigned		re_engine;
     unsigned		re_flags;    /* second argument for vim_regcomp() */
+    int			re_refcount;
+    regstat_T		*re_stat;
+    linenr_T		re_maxlines;
 
     int			regstart;
     char_u		reganch;
     char_u		*regmust;
     int			regmlen;
+    int			regmoff;
 #ifdef FEAT_SYN_HL
     char_u		reghasz;
 #endif
@@ -92,22 +100,28 @@ struct nfa_state
     int			val;
 };
 
+typedef struct nfa_dfa_S nfa_dfa_T;
+
 /*
  * Structure used by the NFA matcher.
  */
 typedef struct
 {
-    /* These three members implement regprog_T */
+    /* These seven members implement regprog_T */
     regengine_T		*engine;
     unsigned		regflags;
     unsigned		re_engine;
     unsigned		re_flags;    /* second argument for vim_regcomp() */
+    int			re_refcount;
+    regstat_T		*re_stat;
+    linenr_T		re_maxlines;
 
     nfa_state_T		*start;		/* points into state[] */
 
     int			reganch;	/* pattern starts with ^ */
     int			regstart;	/* char at start of pattern */
     char_u		*match_text;	/* plain text to match with */
+    int			must_char;	/* char that must be in a match or NUL */
 
     int			has_zend;	/* pattern contains \ze */
     int			has_backref;	/* pattern contains \1 .. \9 */
@@ -115,6 +129,8 @@ typedef struct
     int			reghasz;
 #endif
     char_u		*pattern;
+    nfa_dfa_T		*dfa;		/* lazily built DFA or NULL */
+    char_u		*coll_bits;	/* ASCII bitmaps for collections */
     int			nsubexp;	/* number of () */
     int			nstate;
     nfa_state_T		state[1];	/* actually longer.. */
@@ -273,6 +273,13 @@ static int istate;	/* Index in the state vector, used in alloc_state() */
 /* If not NULL match must end at this position */
 static save_se_T *nfa_endp = NULL;
 
+/* Bitmaps of the ASCII characters matched by the collections of the program
+ * being executed, see nfa_coll_bitmaps(). */
+static char_u *nfa_coll_bits = NULL;
+
+#define NFA_COLL_ASCII	    0x80    /* characters in a collection bitmap */
+#define NFA_COLL_BYTES	    (NFA_COLL_ASCII / 8)
+
 /* listid is global, so that it increases on recursive calls to
  * nfa_regmatch(), which means we don't have to clear the lastlist field of
  * all the states. */
@@ -286,6 +293,9 @@ static int nfa_regcomp_start(char_u *expr, int re_flags);
 static int nfa_get_reganch(nfa_state_T *start, int depth);
 static int nfa_get_regstart(nfa_state_T *start, int depth);
 static char_u *nfa_get_match_text(nfa_state_T *start);
+static int nfa_match_without(nfa_regprog_T *prog, nfa_state_T *state, nfa_state_T *avoid, char_u *seen);
+static int nfa_get_must_char(nfa_regprog_T *prog);
+static int nfa_dfa_usable(nfa_regprog_T *prog);
 static int realloc_post_list(void);
 static int nfa_recognize_char_class(char_u *start, char_u *end, int extra_newl);
 static int nfa_emit_equi_class(int c);
@@ -308,10 +318,14 @@ static int nfa_max_width(nfa_state_T *startstate, int depth);
 static nfa_state_T *post2nfa(int *postfix, int *end, int nfa_calc_size);
 static void nfa_postprocess(nfa_regprog_T *prog);
 static int check_char_class(int class, int c);
+static int nfa_match_coll(nfa_state_T *start, int curc);
+static void nfa_coll_bitmaps(nfa_regprog_T *prog);
 static void nfa_save_listids(nfa_regprog_T *prog, int *list);
 static void nfa_restore_listids(nfa_regprog_T *prog, int *list);
 static int nfa_re_num_cmp(long_u val, int op, long_u pos);
 static long nfa_regtry(nfa_regprog_T *prog, colnr_T col, proftime_T *tm);
+static int nfa_dfa_may_match(nfa_regprog_T *prog, colnr_T col);
+static void nfa_dfa_free(nfa_dfa_T *dfa);
 static long nfa_regexec_both(char_u *line, colnr_T col, proftime_T *tm);
 static regprog_T *nfa_regcomp(char_u *expr, int re_flags);
 static void nfa_regfree(regprog_T *prog);
@@ -554,6 +568,80 @@ nfa_get_match_text(nfa_state_T *start)
     return ret;
 }
 
+/*
+ * Return TRUE if NFA_MATCH can be reached from "state" without going through
+ * state "avoid".  "seen[]" is TRUE for states that were already visited.
+ */
+    static int
+nfa_match_without(
+    nfa_regprog_T	*prog,
+    nfa_state_T		*state,
+    nfa_state_T		*avoid,
+    char_u		*seen)
+{
+    for (;;)
+    {
+	if (state == avoid || seen[state - prog->state])
+	    return FALSE;
+	seen[state - prog->state] = TRUE;
+	switch (state->c)
+	{
+	    case NFA_MATCH:
+		return TRUE;
+
+	    case NFA_SPLIT:
+		if (nfa_match_without(prog, state->out, avoid, seen))
+		    return TRUE;
+		state = state->out1;
+		break;
+
+	    case NFA_START_COLL:
+	    case NFA_START_NEG_COLL:
+		/* skip over the characters in the collection */
+		state = state->out1->out;
+		break;
+
+	    default:
+		state = state->out;
+		break;
+	}
+    }
+}
+
+/*
+ * Find an ASCII character that appears in every match, the least common one
+ * when there are several.  Returns NUL if there is none.
+ */
+    static int
+nfa_get_must_char(nfa_regprog_T *prog)
+{
+    char_u	*seen;
+    int		i;
+    int		c;
+    int		must_c = NUL;
+
+    /* Only for a pattern that doesn't match a line break or look around.
+     * Don't bother for a big one, the time taken grows quadratically. */
+    if (prog->nstate > 500 || !nfa_dfa_usable(prog))
+	return NUL;
+    seen = alloc((unsigned)prog->nstate);
+    if (seen == NULL)
+	return NUL;
+    for (i = 0; i < prog->nstate; ++i)
+    {
+	c = prog->state[i].c;
+	if (c > 0 && c < 0x80 && c != prog->regstart
+		&& (must_c == NUL || byte_rarity(c) > byte_rarity(must_c)))
+	{
+	    vim_memset(seen, 0, (size_t)prog->nstate);
+	    if (!nfa_match_without(prog, prog->start, &prog->state[i], seen))
+		must_c = c;
+	}
+    }
+    vim_free(seen);
+    return must_c;
+}
+
 /*
  * Allocate more space for post_start.  Called when
  * running above the estimated number of states.
@@ -3896,6 +3984,13 @@ typedef struct
     int		    has_pim;	/* TRUE when any state has a PIM */
 } nfa_list_T;
 
+/* Thread lists that nfa_regmatch() keeps for the next call, so that they
+ * don't need to be allocated again for every line that is matched. */
+static nfa_list_T nfa_spare_list[2];
+
+/* Don't keep thread lists bigger than this many bytes. */
+#define NFA_SPARE_LIST_MAX  (256 * 1024L)
+
 #ifdef ENABLE_LOG
 static void log_subsexpr(regsubs_T *subs);
 static void log_subexpr(regsub_T *sub);
@@ -4931,6 +5026,110 @@ check_char_class(int class, int c)
     return FAIL;
 }
 
+/*
+ * Check character "curc" against the collection that starts at "start", a
+ * NFA_START_COLL or NFA_START_NEG_COLL state.
+ * Return TRUE if it matches.
+ */
+    static int
+nfa_match_coll(nfa_state_T *start, int curc)
+{
+    nfa_state_T	*state = start->out;
+    int		result_if_matched = (start->c == NFA_START_COLL);
+    int		c1, c2;
+    char_u	*bits;
+
+    /* Most characters are ASCII, use the bitmap made when compiling. */
+    if (start->val > 0 && curc < NFA_COLL_ASCII)
+    {
+	bits = nfa_coll_bits + ((start->val - 1) * 2 + (ireg_ic ? 1 : 0))
+							      * NFA_COLL_BYTES;
+	return (bits[curc >> 3] & (1 << (curc & 7))) != 0;
+    }
+
+    /* What follows is a list of characters, until NFA_END_COLL.
+     * One of them must match or none of them must match. */
+    for (;;)
+    {
+	if (state->c == NFA_END_COLL)
+	    return !result_if_matched;
+	if (state->c == NFA_RANGE_MIN)
+	{
+	    c1 = state->val;
+	    state = state->out; /* advance to NFA_RANGE_MAX */
+	    c2 = state->val;
+#ifdef ENABLE_LOG
+	    fprintf(log_fd, "NFA_RANGE_MIN curc=%d c1=%d c2=%d\n",
+		    curc, c1, c2);
+#endif
+	    if (curc >= c1 && curc <= c2)
+		return result_if_matched;
+	    if (ireg_ic)
+	    {
+		int curc_low = MB_TOLOWER(curc);
+
+		for ( ; c1 <= c2; ++c1)
+		    if (MB_TOLOWER(c1) == curc_low)
+			return result_if_matched;
+	    }
+	}
+	else if (state->c < 0 ? check_char_class(state->c, curc)
+		    : (curc == state->c
+			|| (ireg_ic && MB_TOLOWER(curc)
+						    == MB_TOLOWER(state->c))))
+	    return result_if_matched;
+	state = state->out;
+    }
+}
+
+/*
+ * Make bitmaps for the ASCII characters matched by each collection in "prog",
+ * one for matching case and one for ignoring case.  The number of the
+ * bitmaps, plus one, is stored in "val" of the NFA_START_COLL or
+ * NFA_START_NEG_COLL state.
+ */
+    static void
+nfa_coll_bitmaps(nfa_regprog_T *prog)
+{
+    int		i;
+    int		n = 0;
+    int		ic;
+    int		c;
+    int		save_ireg_ic = ireg_ic;
+    nfa_state_T	*state;
+    char_u	*bits;
+
+    prog->coll_bits = NULL;
+    for (i = 0; i < prog->nstate; ++i)
+	if (prog->state[i].c == NFA_START_COLL
+				     || prog->state[i].c == NFA_START_NEG_COLL)
+	    ++n;
+    if (n == 0)
+	return;
+    prog->coll_bits = alloc_clear((unsigned)(n * 2 * NFA_COLL_BYTES));
+    if (prog->coll_bits == NULL)
+	return;
+
+    bits = prog->coll_bits;
+    n = 0;
+    for (i = 0; i < prog->nstate; ++i)
+    {
+	state = &prog->state[i];
+	if (state->c != NFA_START_COLL && state->c != NFA_START_NEG_COLL)
+	    continue;
+	for (ic = FALSE; ic <= TRUE; ++ic)
+	{
+	    ireg_ic = ic;
+	    for (c = 1; c < NFA_COLL_ASCII; ++c)
+		if (nfa_match_coll(state, c))
+		    bits[c >> 3] |= 1 << (c & 7);
+	    bits += NFA_COLL_BYTES;
+	}
+	state->val = ++n;
+    }
+    ireg_ic = save_ireg_ic;
+}
+
 /*
  * Check for a match with subexpression "subidx".
  * Return TRUE if it matches.
@@ -5076,6 +5275,64 @@ nfa_re_num_cmp(long_u val, int op, long_u pos)
 static int recursive_regmatch(nfa_state_T *state, nfa_pim_T *pim, nfa_regprog_T *prog, regsubs_T *submatch, regsubs_T *m, int **listids);
 static int nfa_regmatch(nfa_regprog_T *prog, nfa_state_T *start, regsubs_T *submatch, regsubs_T *m);
 
+/*
+ * Get an array for thread list "l" with room for at least "len" threads.
+ * Uses a spare one when possible.
+ * Returns FAIL when out of memory.
+ */
+    static int
+nfa_get_list(nfa_list_T *l, int len)
+{
+    int		i;
+
+    for (i = 0; i < 2; ++i)
+	if (nfa_spare_list[i].t != NULL && nfa_spare_list[i].len >= len)
+	{
+	    l->t = nfa_spare_list[i].t;
+	    l->len = nfa_spare_list[i].len;
+	    nfa_spare_list[i].t = NULL;
+	    return OK;
+	}
+    l->t = (nfa_thread_T *)lalloc(len * sizeof(nfa_thread_T), TRUE);
+    l->len = len;
+    return l->t == NULL ? FAIL : OK;
+}
+
+/*
+ * Done with the array of thread list "l".  Keep it for the next call if it
+ * is bigger than a spare one, free it otherwise.
+ */
+    static void
+nfa_put_list(nfa_list_T *l)
+{
+    int		i;
+
+    if (l->t != NULL && l->len * (long)sizeof(nfa_thread_T)
+							<= NFA_SPARE_LIST_MAX)
+	for (i = 0; i < 2; ++i)
+	    if (nfa_spare_list[i].t == NULL || nfa_spare_list[i].len < l->len)
+	    {
+		vim_free(nfa_spare_list[i].t);
+		nfa_spare_list[i].t = l->t;
+		nfa_spare_list[i].len = l->len;
+		l->t = NULL;
+		return;
+	    }
+    vim_free(l->t);
+    l->t = NULL;
+}
+
+#if defined(EXITFREE) || defined(PROTO)
+    static void
+nfa_free_spare_lists(void)
+{
+    vim_free(nfa_spare_list[0].t);
+    vim_free(nfa_spare_list[1].t);
+    nfa_spare_list[0].t = NULL;
+    nfa_spare_list[1].t = NULL;
+}
+#endif
+
 /*
  * Recursively call nfa_regmatch()
  * "pim" is NULL or contains info about a Postponed Invisible Match (start
@@ -5525,7 +5782,6 @@ nfa_regmatch(
     regsubs_T		*m)
 {
     int		result;
-    size_t	size = 0;
     int		flag = 0;
     int		go_to_nextline = FALSE;
     nfa_thread_T *t;
@@ -5563,14 +5819,10 @@ nfa_regmatch(
 #endif
     nfa_match = FALSE;
 
-    /* Allocate memory for the lists of nodes. */
-    size = (nstate + 1) * sizeof(nfa_thread_T);
-
-    list[0].t = (nfa_thread_T *)lalloc(size, TRUE);
-    list[0].len = nstate + 1;
-    list[1].t = (nfa_thread_T *)lalloc(size, TRUE);
-    list[1].len = nstate + 1;
-    if (list[0].t == NULL || list[1].t == NULL)
+    /* Get memory for the lists of nodes. */
+    list[1].t = NULL;
+    if (nfa_get_list(&list[0], nstate + 1) == FAIL
+				 || nfa_get_list(&list[1], nstate + 1) == FAIL)
 	goto theend;
 
 #ifdef ENABLE_LOG
@@ -6209,68 +6461,9 @@ nfa_regmatch(
 
 	    case NFA_START_COLL:
 	    case NFA_START_NEG_COLL:
-	      {
-		/* What follows is a list of characters, until NFA_END_COLL.
-		 * One of them must match or none of them must match. */
-		nfa_state_T	*state;
-		int		result_if_matched;
-		int		c1, c2;
-
 		/* Never match EOL. If it's part of the collection it is added
 		 * as a separate state with an OR. */
-		if (curc == NUL)
-		    break;
-
-		state = t->state->out;
-		result_if_matched = (t->state->c == NFA_START_COLL);
-		for (;;)
-		{
-		    if (state->c == NFA_END_COLL)
-		    {
-			result = !result_if_matched;
-			break;
-		    }
-		    if (state->c == NFA_RANGE_MIN)
-		    {
-			c1 = state->val;
-			state = state->out; /* advance to NFA_RANGE_MAX */
-			c2 = state->val;
-#ifdef ENABLE_LOG
-			fprintf(log_fd, "NFA_RANGE_MIN curc=%d c1=%d c2=%d\n",
-				curc, c1, c2);
-#endif
-			if (curc >= c1 && curc <= c2)
-			{
-			    result = result_if_matched;
-			    break;
-			}
-			if (ireg_ic)
-			{
-			    int curc_low = MB_TOLOWER(curc);
-			    int done = FALSE;
-
-			    for ( ; c1 <= c2; ++c1)
-				if (MB_TOLOWER(c1) == curc_low)
-				{
-				    result = result_if_matched;
-				    done = TRUE;
-				    break;
-				}
-			    if (done)
-				break;
-			}
-		    }
-		    else if (state->c < 0 ? check_char_class(state->c, curc)
-			        : (curc == state->c
-				   || (ireg_ic && MB_TOLOWER(curc)
-						    == MB_TOLOWER(state->c))))
-		    {
-			result = result_if_matched;
-			break;
-		    }
-		    state = state->out;
-		}
-		if (result)
+		if (curc != NUL && nfa_match_coll(t->state, curc))
 		{
 		    /* next state is in out of the NFA_END_COLL, out1 of
 		     * START points to the END state */
@@ -6278,7 +6471,6 @@ nfa_regmatch(
 		    add_off = clen;
 		}
 		break;
-	      }
 
 	    case NFA_ANY:
 		/* Any char except '\0', (end of input) does not match. */
@@ -6925,9 +7117,9 @@ nextchar:
 #endif
 
 theend:
-    /* Free memory */
-    vim_free(list[0].t);
-    vim_free(list[1].t);
+    /* Free memory, keep the lists for the next call. */
+    nfa_put_list(&list[0]);
+    nfa_put_list(&list[1]);
     vim_free(listids);
 #undef ADD_STATE_IF_MATCH
 #ifdef NFA_REGEXP_DEBUG_LOG
@@ -7074,6 +7266,480 @@ nfa_regtry(
     return 1 + reglnum;
 }
 
+/*
+ * A DFA that is built lazily from the NFA is used to quickly find out that a
+ * line does not contain a match, without running the NFA.  It only handles
+ * ASCII text and patterns made of characters, collections, character
+ * classes, "^", "$", "\<" and "\>".  Otherwise nfa_dfa_may_match() returns
+ * TRUE and the NFA does the work.
+ *
+ * A DFA state is the set of NFA states waiting for the next character, plus
+ * whether it is at the start of the line and whether the previous character
+ * is a word character.  A transition is computed when it is used for the
+ * first time.  Memory for the states is limited by 'maxmempattern'.
+ */
+typedef struct nfa_dstate_S nfa_dstate_T;
+
+#define NFA_DFA_BOL	1	/* at the start of the line */
+#define NFA_DFA_WORD	2	/* previous character is a word character */
+
+#define NFA_DFA_HASHSIZE 256
+
+struct nfa_dstate_S
+{
+    nfa_dstate_T    *next;	/* next state with the same hash */
+    nfa_dstate_T    *trans[128]; /* next state for each ASCII character, the
+				   NUL is for the end of the line; NULL when
+				   not computed yet */
+    unsigned	    hash;
+    int		    flags;	/* NFA_DFA_BOL and NFA_DFA_WORD */
+    char_u	    set[1];	/* bit for each NFA state, actually longer */
+};
+
+struct nfa_dfa_S
+{
+    int		    failed;	/* TRUE when the DFA can't be used */
+    int		    need_word;	/* pattern contains "\<" or "\>" */
+    int		    ic;		/* value of ireg_ic the states are for */
+    char_u	    chartab[16]; /* ASCII part of the b_chartab the states
+				   are for */
+    int		    setlen;	/* number of bytes in a set */
+    long	    mem;	/* bytes allocated for states */
+    nfa_dstate_T    *init[4];	/* start state for each "flags" value */
+    nfa_dstate_T    *table[NFA_DFA_HASHSIZE];
+    char_u	    *seen;	/* states visited in nfa_dfa_step() */
+    char_u	    *nextset;	/* states for the next DFA state */
+    nfa_state_T	    **stack;	/* states to be visited */
+};
+
+/* Transition results for the end of the line. */
+static nfa_dstate_T nfa_dfa_match;
+static nfa_dstate_T nfa_dfa_nomatch;
+
+/*
+ * Return TRUE when all states of "prog" can be handled by the DFA.
+ */
+    static int
+nfa_dfa_usable(nfa_regprog_T *prog)
+{
+    int		i;
+    int		c;
+
+    for (i = 0; i < prog->nstate; ++i)
+    {
+	c = prog->state[i].c;
+	if (c > 0
+		|| (c >= NFA_MOPEN && c <= NFA_MCLOSE9)
+#ifdef FEAT_SYN_HL
+		|| (c >= NFA_ZOPEN && c <= NFA_ZCLOSE9)
+#endif
+		|| (c >= NFA_ANY && c <= NFA_NUPPER_IC
+			     && c != NFA_IDENT && c != NFA_SIDENT
+			     && c != NFA_FNAME && c != NFA_SFNAME
+			     && c != NFA_PRINT && c != NFA_SPRINT)
+		|| (c >= NFA_CLASS_ALNUM && c <= NFA_CLASS_ESCAPE
+			     && c != NFA_CLASS_PRINT))
+	    continue;
+	switch (c)
+	{
+	    case NFA_SPLIT:
+	    case NFA_MATCH:
+	    case NFA_EMPTY:
+	    case NFA_START_COLL:
+	    case NFA_END_COLL:
+	    case NFA_START_NEG_COLL:
+	    case NFA_END_NEG_COLL:
+	    case NFA_RANGE_MIN:
+	    case NFA_RANGE_MAX:
+	    case NFA_BOL:
+	    case NFA_EOL:
+	    case NFA_BOW:
+	    case NFA_EOW:
+	    case NFA_ZSTART:
+	    case NFA_ZEND:
+	    case NFA_NOPEN:
+	    case NFA_NCLOSE:
+	    case NFA_ANY_COMPOSING:
+		break;
+	    default:
+		return FALSE;
+	}
+    }
+    return TRUE;
+}
+
+/*
+ * Allocate the DFA for "prog".
+ * Returns NULL when out of memory.
+ */
+    static nfa_dfa_T *
+nfa_dfa_new(nfa_regprog_T *prog)
+{
+    nfa_dfa_T	*dfa;
+    int		i;
+
+    dfa = (nfa_dfa_T *)alloc_clear((unsigned)sizeof(nfa_dfa_T));
+    if (dfa == NULL)
+	return NULL;
+    if (!nfa_dfa_usable(prog))
+	dfa->failed = TRUE;
+    else
+    {
+	dfa->setlen = (prog->nstate + 7) / 8;
+	dfa->seen = alloc((unsigned)dfa->setlen * 2);
+	dfa->stack = (nfa_state_T **)alloc(
+				(unsigned)(prog->nstate * sizeof(nfa_state_T *)));
+	if (dfa->seen == NULL || dfa->stack == NULL)
+	    dfa->failed = TRUE;
+	else
+	    dfa->nextset = dfa->seen + dfa->setlen;
+	for (i = 0; i < prog->nstate; ++i)
+	    if (prog->state[i].c == NFA_BOW || prog->state[i].c == NFA_EOW)
+		dfa->need_word = TRUE;
+    }
+    return dfa;
+}
+
+/*
+ * Free all the states of "dfa".
+ */
+    static void
+nfa_dfa_clear(nfa_dfa_T *dfa)
+{
+    int		    i;
+    nfa_dstate_T    *d;
+
+    for (i = 0; i < NFA_DFA_HASHSIZE; ++i)
+	while (dfa->table[i] != NULL)
+	{
+	    d = dfa->table[i];
+	    dfa->table[i] = d->next;
+	    vim_free(d);
+	}
+    for (i = 0; i < 4; ++i)
+	dfa->init[i] = NULL;
+    dfa->mem = 0;
+}
+
+    static void
+nfa_dfa_free(nfa_dfa_T *dfa)
+{
+    if (dfa != NULL)
+    {
+	nfa_dfa_clear(dfa);
+	vim_free(dfa->seen);
+	vim_free(dfa->stack);
+	vim_free(dfa);
+    }
+}
+
+/*
+ * Find the DFA state for NFA states "set" and "flags", add it when it
+ * doesn't exist yet.
+ * Returns NULL when out of memory or when 'maxmempattern' would be exceeded.
+ */
+    static nfa_dstate_T *
+nfa_dfa_find(nfa_dfa_T *dfa, char_u *set, int flags)
+{
+    unsigned	    hash = flags;
+    int		    i;
+    nfa_dstate_T    *d;
+    long	    size;
+
+    for (i = 0; i < dfa->setlen; ++i)
+	hash = hash * 33 + set[i];
+    for (d = dfa->table[hash % NFA_DFA_HASHSIZE]; d != NULL; d = d->next)
+	if (d->hash == hash && d->flags == flags
+				 && memcmp(d->set, set, dfa->setlen) == 0)
+	    return d;
+
+    size = sizeof(nfa_dstate_T) + dfa->setlen;
+    if (dfa->mem + size > p_mmp * 1024L)
+    {
+	dfa->failed = TRUE;
+	return NULL;
+    }
+    d = (nfa_dstate_T *)alloc_clear((unsigned)size);
+    if (d == NULL)
+    {
+	dfa->failed = TRUE;
+	return NULL;
+    }
+    dfa->mem += size;
+    d->hash = hash;
+    d->flags = flags;
+    mch_memmove(d->set, set, (size_t)dfa->setlen);
+    d->next = dfa->table[hash % NFA_DFA_HASHSIZE];
+    dfa->table[hash % NFA_DFA_HASHSIZE] = d;
+    return d;
+}
+
+/*
+ * Return the state that follows NFA state "state" when it consumes ASCII
+ * character "c", NULL if it doesn't match.  Must check the same way as
+ * nfa_regmatch().
+ */
+    static nfa_state_T *
+nfa_dfa_consume(nfa_state_T *state, int c)
+{
+    int		result;
+
+    switch (state->c)
+    {
+	case NFA_START_COLL:
+	case NFA_START_NEG_COLL:
+	    return nfa_match_coll(state, c) ? state->out1->out : NULL;
+
+	case NFA_ANY:	    result = TRUE; break;
+	case NFA_KWORD:	    result = vim_iswordc_buf(c, reg_buf); break;
+	case NFA_SKWORD:    result = !VIM_ISDIGIT(c)
+					      && vim_iswordc_buf(c, reg_buf);
+			    break;
+	case NFA_WHITE:	    result = vim_iswhite(c); break;
+	case NFA_NWHITE:    result = !vim_iswhite(c); break;
+	case NFA_DIGIT:	    result = ri_digit(c); break;
+	case NFA_NDIGIT:    result = !ri_digit(c); break;
+	case NFA_HEX:	    result = ri_hex(c); break;
+	case NFA_NHEX:	    result = !ri_hex(c); break;
+	case NFA_OCTAL:	    result = ri_octal(c); break;
+	case NFA_NOCTAL:    result = !ri_octal(c); break;
+	case NFA_WORD:	    result = ri_word(c); break;
+	case NFA_NWORD:	    result = !ri_word(c); break;
+	case NFA_HEAD:	    result = ri_head(c); break;
+	case NFA_NHEAD:	    result = !ri_head(c); break;
+	case NFA_ALPHA:	    result = ri_alpha(c); break;
+	case NFA_NALPHA:    result = !ri_alpha(c); break;
+	case NFA_LOWER:	    result = ri_lower(c); break;
+	case NFA_NLOWER:    result = !ri_lower(c); break;
+	case NFA_UPPER:	    result = ri_upper(c); break;
+	case NFA_NUPPER:    result = !ri_upper(c); break;
+	case NFA_LOWER_IC:  result = ri_lower(c) || (ireg_ic && ri_upper(c));
+			    break;
+	case NFA_NLOWER_IC: result = !(ri_lower(c)
+					       || (ireg_ic && ri_upper(c)));
+			    break;
+	case NFA_UPPER_IC:  result = ri_upper(c) || (ireg_ic && ri_lower(c));
+			    break;
+	case NFA_NUPPER_IC: result = !(ri_upper(c)
+					       || (ireg_ic && ri_lower(c)));
+			    break;
+
+	default:	/* regular character */
+	    result = state->c == c
+			|| (ireg_ic && MB_TOLOWER(state->c) == MB_TOLOWER(c));
+	    break;
+    }
+    return result ? state->out : NULL;
+}
+
+/*
+ * Compute the transition from DFA state "d" for ASCII character "c", NUL for
+ * the end of the line.
+ * Returns NULL when out of memory or the DFA got too big.
+ */
+    static nfa_dstate_T *
+nfa_dfa_step(nfa_regprog_T *prog, nfa_dstate_T *d, int c)
+{
+    nfa_dfa_T	*dfa = prog->dfa;
+    nfa_state_T	*state;
+    nfa_state_T	*next;
+    int		sp = 0;
+    int		i;
+    int		word = c != NUL && vim_iswordc_buf(c, reg_buf);
+
+#define DFA_PUSH(s) do { \
+	    i = (int)((s) - prog->state); \
+	    if (!(dfa->seen[i >> 3] & (1 << (i & 7)))) \
+	    { \
+		dfa->seen[i >> 3] |= 1 << (i & 7); \
+		dfa->stack[sp++] = (s); \
+	    } \
+	} while (0)
+
+    vim_memset(dfa->seen, 0, (size_t)dfa->setlen * 2);
+
+    /* A match may start at any position. */
+    DFA_PUSH(prog->start);
+    for (i = 0; i < prog->nstate; ++i)
+	if (d->set[i >> 3] & (1 << (i & 7)))
+	{
+	    state = &prog->state[i];
+	    DFA_PUSH(state);
+	}
+
+    while (sp > 0)
+    {
+	state = dfa->stack[--sp];
+	switch (state->c)
+	{
+	    case NFA_MATCH:
+		return &nfa_dfa_match;
+
+	    case NFA_SPLIT:
+		DFA_PUSH(state->out);
+		DFA_PUSH(state->out1);
+		break;
+
+	    case NFA_BOL:
+		if (d->flags & NFA_DFA_BOL)
+		    DFA_PUSH(state->out);
+		break;
+
+	    case NFA_EOL:
+		if (c == NUL)
+		    DFA_PUSH(state->out);
+		break;
+
+	    case NFA_BOW:
+		if (word && !(d->flags & NFA_DFA_WORD))
+		    DFA_PUSH(state->out);
+		break;
+
+	    case NFA_EOW:
+		if ((d->flags & NFA_DFA_WORD) && !word)
+		    DFA_PUSH(state->out);
+		break;
+
+	    case NFA_START_COLL:
+	    case NFA_START_NEG_COLL:
+	    case NFA_ANY:
+	    case NFA_KWORD:
+	    case NFA_SKWORD:
+	    case NFA_WHITE:
+	    case NFA_NWHITE:
+	    case NFA_DIGIT:
+	    case NFA_NDIGIT:
+	    case NFA_HEX:
+	    case NFA_NHEX:
+	    case NFA_OCTAL:
+	    case NFA_NOCTAL:
+	    case NFA_WORD:
+	    case NFA_NWORD:
+	    case NFA_HEAD:
+	    case NFA_NHEAD:
+	    case NFA_ALPHA:
+	    case NFA_NALPHA:
+	    case NFA_LOWER:
+	    case NFA_NLOWER:
+	    case NFA_UPPER:
+	    case NFA_NUPPER:
+	    case NFA_LOWER_IC:
+	    case NFA_NLOWER_IC:
+	    case NFA_UPPER_IC:
+	    case NFA_NUPPER_IC:
+		if (c != NUL && (next = nfa_dfa_consume(state, c)) != NULL)
+		{
+		    i = (int)(next - prog->state);
+		    dfa->nextset[i >> 3] |= 1 << (i & 7);
+		}
+		break;
+
+	    default:
+		if (state->c > 0)
+		{
+		    /* regular character */
+		    if (c != NUL && (next = nfa_dfa_consume(state, c)) != NULL)
+		    {
+			i = (int)(next - prog->state);
+			dfa->nextset[i >> 3] |= 1 << (i & 7);
+		    }
+		}
+		else
+		    /* MOPEN, NOPEN, ZSTART, EMPTY, etc. */
+		    DFA_PUSH(state->out);
+		break;
+	}
+    }
+#undef DFA_PUSH
+
+    if (c == NUL)
+	return &nfa_dfa_nomatch;
+    return nfa_dfa_find(dfa, dfa->nextset,
+				     dfa->need_word && word ? NFA_DFA_WORD : 0);
+}
+
+/*
+ * Use the DFA to check if there can be a match in regline, starting at
+ * "col" or later.
+ * Returns FALSE when there certainly is no match, TRUE when there might be
+ * one.
+ */
+    static int
+nfa_dfa_may_match(nfa_regprog_T *prog, colnr_T col)
+{
+    nfa_dfa_T	    *dfa = prog->dfa;
+    nfa_dstate_T    *d;
+    nfa_dstate_T    *next;
+    char_u	    *p = regline + col;
+    int		    flags;
+    int		    c;
+
+#ifdef FEAT_MBYTE
+    /* With a double-byte encoding a trail byte can be ASCII. */
+    if (has_mbyte && !enc_utf8)
+	return TRUE;
+#endif
+    if (dfa == NULL)
+    {
+	dfa = prog->dfa = nfa_dfa_new(prog);
+	if (dfa == NULL)
+	    return TRUE;
+    }
+    if (dfa->failed)
+	return TRUE;
+
+    /* The states depend on 'ignorecase' and 'iskeyword'. */
+    if (dfa->ic != ireg_ic || memcmp(dfa->chartab, reg_buf->b_chartab,
+						      sizeof(dfa->chartab)) != 0)
+    {
+	nfa_dfa_clear(dfa);
+	dfa->ic = ireg_ic;
+	mch_memmove(dfa->chartab, reg_buf->b_chartab, sizeof(dfa->chartab));
+    }
+
+    if (col == 0)
+	flags = NFA_DFA_BOL;
+    else if (p[-1] >= 0x80)
+	return TRUE;
+    else
+	flags = dfa->need_word && vim_iswordc_buf(p[-1], reg_buf)
+							   ? NFA_DFA_WORD : 0;
+    d = dfa->init[flags];
+    if (d == NULL)
+    {
+	vim_memset(dfa->nextset, 0, (size_t)dfa->setlen);
+	d = dfa->init[flags] = nfa_dfa_find(dfa, dfa->nextset, flags);
+	if (d == NULL)
+	{
+	    nfa_dfa_clear(dfa);
+	    return TRUE;
+	}
+    }
+
+    for (;;)
+    {
+	c = *p++;
+	if (c >= 0x80)
+	    return TRUE;
+	next = d->trans[c];
+	if (next == NULL)
+	{
+	    next = nfa_dfa_step(prog, d, c);
+	    if (next == NULL)
+	    {
+		nfa_dfa_clear(dfa);
+		return TRUE;
+	    }
+	    d->trans[c] = next;
+	}
+	if (next == &nfa_dfa_match)
+	    return TRUE;
+	if (next == &nfa_dfa_nomatch)
+	    return FALSE;
+	d = next;
+    }
+}
+
 /*
  * Match a regexp against a string ("line" points to the string) or multiple
  * lines ("line" is NULL, use reg_getline()).
@@ -7130,6 +7796,7 @@ nfa_regexec_both(
     nfa_has_zend = prog->has_zend;
     nfa_has_backref = prog->has_backref;
     nfa_nsubexpr = prog->nsubexp;
+    nfa_coll_bits = prog->coll_bits;
     nfa_listid = 1;
     nfa_alt_listid = 2;
     nfa_regengine.expr = prog->pattern;
@@ -7170,6 +7837,20 @@ nfa_regexec_both(
     if (ireg_maxcol > 0 && col >= ireg_maxcol)
 	goto theend;
 
+    /* A character that must appear in a match is quickly found.  If it's
+     * not there then there is no match. */
+    if (prog->must_char != NUL
+#ifdef FEAT_MBYTE
+	    && !(ireg_ic && ascii_has_mb_fold(prog->must_char))
+#endif
+	    && cstrchr(regline + col, prog->must_char) == NULL)
+	goto theend;
+
+    /* When the DFA finds there is no match in the line the NFA doesn't need
+     * to be run. */
+    if (!nfa_dfa_may_match(prog, col))
+	goto theend;
+
     nstate = prog->nstate;
     for (i = 0; i < nstate; ++i)
     {
@@ -7265,10 +7946,12 @@ nfa_regcomp(char_u *expr, int re_flags)
     prog->nsubexp = regnpar;
 
     nfa_postprocess(prog);
+    nfa_coll_bitmaps(prog);
 
     prog->reganch = nfa_get_reganch(prog->start, 0);
     prog->regstart = nfa_get_regstart(prog->start, 0);
     prog->match_text = nfa_get_match_text(prog->start);
+    prog->must_char = nfa_get_must_char(prog);
 
 #ifdef ENABLE_LOG
     nfa_postfix_dump(expr, OK);
@@ -7279,6 +7962,7 @@ nfa_regcomp(char_u *expr, int re_flags)
     prog->reghasz = re_has_z;
 #endif
     prog->pattern = vim_strsave(expr);
+    prog->dfa = NULL;
     nfa_regengine.expr = NULL;
 
 out:
@@ -7305,6 +7989,8 @@ nfa_regfree(regprog_T *prog)
 {
     if (prog != NULL)
     {
+	nfa_dfa_free(((nfa_regprog_T *)prog)->dfa);
+	vim_free(((nfa_regprog_T *)prog)->coll_bits);
 	vim_free(((nfa_regprog_T *)prog)->match_text);
 	vim_free(((nfa_regprog_T *)prog)->pattern);
 	vim_free(prog);
@@ -179,6 +179,15 @@ static void win_redr_custom(win_T *wp, int draw_ruler);
 #ifdef FEAT_CMDL_INFO
 static void win_redr_ruler(win_T *wp, int always);
 #endif
+#ifdef FEAT_PROFILE
+static void redraw_prof_begin(void);
+static void redraw_prof_finish(void);
+static void redraw_prof_add(int item, proftime_T *tm);
+static int redraw_prof_bucket(proftime_T *tm);
+static void redraw_prof_clear(void);
+static void redraw_prof_report(void);
+static void redraw_prof_dump(char_u *fname);
+#endif
 
 #if defined(FEAT_CLIPBOARD) || defined(FEAT_WINDOWS)
 /* Ugly global: overrule attribute used by screen_char() */
@@ -535,6 +544,9 @@ update_screen(int type)
     }
 
     updating_screen = TRUE;
+#ifdef FEAT_PROFILE
+    redraw_prof_begin();
+#endif
 #ifdef FEAT_SYN_HL
     ++display_tick;	    /* let syntax code know we're in a next round of
 			     * display updating */
@@ -772,6 +784,9 @@ update_screen(int type)
 	gui_update_scrollbars(FALSE);
     }
 #endif
+#ifdef FEAT_PROFILE
+    redraw_prof_finish();
+#endif
 }
 
 #if defined(FEAT_CONCEAL) || defined(PROTO)
@@ -878,6 +893,9 @@ update_prepare(void)
 {
     cursor_off();
     updating_screen = TRUE;
+#ifdef FEAT_PROFILE
+    redraw_prof_begin();
+#endif
 #ifdef FEAT_GUI
     /* Remove the cursor before starting to do anything, because scrolling may
      * make it difficult to redraw the text under it. */
@@ -916,6 +934,9 @@ update_finish(void)
 	gui_update_scrollbars(FALSE);
     }
 # endif
+# ifdef FEAT_PROFILE
+    redraw_prof_finish();
+# endif
 }
 #endif
 
@@ -1100,6 +1121,9 @@ win_update(win_T *wp)
 #if defined(FEAT_SYN_HL) || defined(FEAT_SEARCH_EXTRA)
     int		save_got_int;
 #endif
+#ifdef FEAT_PROFILE
+    proftime_T	prof_tm;
+#endif
 
     type = wp->w_redr_type;
 
@@ -1129,6 +1153,12 @@ win_update(win_T *wp)
     }
 #endif
 
+#ifdef FEAT_PROFILE
+    /* The recursive call is part of the time of this one. */
+    if (redraw_prof_active && !recursive)
+	profile_start(&prof_tm);
+#endif
+
 #ifdef FEAT_SEARCH_EXTRA
     init_search_hl(wp);
 #endif
@@ -1189,25 +1219,28 @@ win_update(win_T *wp)
 #ifdef FEAT_SEARCH_EXTRA
 	    /* When 'hlsearch' is on and using a multi-line search pattern, a
 	     * change in one line may make the Search highlighting in a
-	     * previous line invalid.  Simple solution: redraw all visible
-	     * lines above the change.
+	     * previous line invalid.  Redraw the lines above the change that a
+	     * match can span, all visible lines above the change when the
+	     * pattern has no limit.
 	     * Same for a match pattern.
 	     */
-	    if (search_hl.rm.regprog != NULL
-					&& re_multiline(search_hl.rm.regprog))
-		top_to_mod = TRUE;
-	    else
 	    {
-		cur = wp->w_match_head;
-		while (cur != NULL)
-		{
+		linenr_T    maxlines = 0;
+
+		if (search_hl.rm.regprog != NULL)
+		    maxlines = re_maxlines(search_hl.rm.regprog);
+		for (cur = wp->w_match_head; cur != NULL
+					&& maxlines < MAXLNUM; cur = cur->next)
 		    if (cur->match.regprog != NULL
-					   && re_multiline(cur->match.regprog))
-		    {
-			top_to_mod = TRUE;
-			break;
-		    }
-		    cur = cur->next;
+			       && re_maxlines(cur->match.regprog) > maxlines)
+			maxlines = re_maxlines(cur->match.regprog);
+		if (maxlines == MAXLNUM)
+		    top_to_mod = TRUE;
+		else if (maxlines > 0)
+		{
+		    mod_top -= maxlines;
+		    if (mod_top < 1)
+			mod_top = 1;
 		}
 	    }
 #endif
@@ -2253,6 +2286,10 @@ win_update(win_T *wp)
     if (!got_int)
 	got_int = save_got_int;
 #endif
+#ifdef FEAT_PROFILE
+    if (redraw_prof_active && !recursive)
+	redraw_prof_end(RDP_WIN_UPDATE, &prof_tm);
+#endif
 }
 
 /*
@@ -2419,6 +2456,12 @@ fold_line(
     int		txtcol;
     int		off = (int)(current_ScreenLine - ScreenLines);
     int		ri;
+#ifdef FEAT_PROFILE
+    proftime_T	prof_tm;
+
+    if (redraw_prof_active)
+	profile_start(&prof_tm);
+#endif
 
     /* Build the fold line:
      * 1. Add the cmdwin_type for the command-line window
@@ -2823,6 +2866,10 @@ fold_line(
 	curwin->w_cline_folded = TRUE;
 	curwin->w_valid |= (VALID_CHEIGHT|VALID_CROW);
     }
+#ifdef FEAT_PROFILE
+    if (redraw_prof_active)
+	redraw_prof_end(RDP_FOLD_LINE, &prof_tm);
+#endif
 }
 
 /*
@@ -3067,6 +3114,13 @@ win_line(
     int		feedback_col = 0;
     int		feedback_old_attr = -1;
 #endif
+#ifdef FEAT_PROFILE
+    proftime_T	prof_tm;
+# ifdef FEAT_SYN_HL
+    proftime_T	syn_prof_tm;
+    proftime_T	syn_prof_line;		/* syntax time for this line */
+# endif
+#endif
 
 #ifdef FEAT_CONCEAL
     int		syntax_flags	= 0;
@@ -3098,6 +3152,11 @@ win_line(
     if (startrow > endrow)		/* past the end already! */
 	return startrow;
 
+#ifdef FEAT_PROFILE
+    if (redraw_prof_active)
+	profile_start(&prof_tm);
+#endif
+
     row = startrow;
     screen_row = row + W_WINROW(wp);
 
@@ -3117,7 +3176,15 @@ win_line(
 	 * error, stop syntax highlighting. */
 	save_did_emsg = did_emsg;
 	did_emsg = FALSE;
+# ifdef FEAT_PROFILE
+	if (redraw_prof_active)
+	    profile_start(&syn_prof_line);
+# endif
 	syntax_start(wp, lnum);
+# ifdef FEAT_PROFILE
+	if (redraw_prof_active)
+	    profile_end(&syn_prof_line);
+# endif
 	if (did_emsg)
 	    wp->w_s->b_syn_error = TRUE;
 	else
@@ -4406,11 +4473,22 @@ win_line(
 		    save_did_emsg = did_emsg;
 		    did_emsg = FALSE;
 
+# ifdef FEAT_PROFILE
+		    if (redraw_prof_active)
+			profile_start(&syn_prof_tm);
+# endif
 		    syntax_attr = get_syntax_attr((colnr_T)v - 1,
 # ifdef FEAT_SPELL
 						has_spell ? &can_spell :
 # endif
 						NULL, FALSE);
+# ifdef FEAT_PROFILE
+		    if (redraw_prof_active)
+		    {
+			profile_end(&syn_prof_tm);
+			profile_add(&syn_prof_line, &syn_prof_tm);
+		    }
+# endif
 
 		    if (did_emsg)
 		    {
@@ -5772,6 +5850,17 @@ win_line(
     }
 #endif
 
+#ifdef FEAT_PROFILE
+    if (redraw_prof_active)
+    {
+# ifdef FEAT_SYN_HL
+	/* The syntax time of the line is added as one item. */
+	if (has_syntax)
+	    redraw_prof_add(RDP_SYNTAX, &syn_prof_line);
+# endif
+	redraw_prof_end(RDP_WIN_LINE, &prof_tm);
+    }
+#endif
     return row;
 }
 
@@ -5878,6 +5967,12 @@ screen_line(
 # define CHAR_CELLS char_cells
 #else
 # define CHAR_CELLS 1
+#endif
+#ifdef FEAT_PROFILE
+    proftime_T	    prof_tm;
+
+    if (redraw_prof_active)
+	profile_start(&prof_tm);
 #endif
 
     /* Check for illegal row and col, just in case. */
@@ -6244,6 +6339,10 @@ screen_line(
 #endif
 	    LineWraps[row] = FALSE;
     }
+#ifdef FEAT_PROFILE
+    if (redraw_prof_active)
+	redraw_prof_end(RDP_SCREEN_LINE, &prof_tm);
+#endif
 }
 
 #if defined(FEAT_RIGHTLEFT) || defined(PROTO)
@@ -7569,6 +7668,12 @@ prepare_search_hl(win_T *wp, linenr_T lnum)
     int		pos_inprogress;	/* marks that position match search is
 				   in progress */
     int		n;
+#ifdef FEAT_PROFILE
+    proftime_T	prof_tm;
+
+    if (redraw_prof_active)
+	profile_start(&prof_tm);
+#endif
 
     /*
      * When using a multi-line pattern, start searching at the top
@@ -7630,6 +7735,10 @@ prepare_search_hl(win_T *wp, linenr_T lnum)
 	if (shl != &search_hl && cur != NULL)
 	    cur = cur->next;
     }
+#ifdef FEAT_PROFILE
+    if (redraw_prof_active)
+	redraw_prof_end(RDP_SEARCH_HL, &prof_tm);
+#endif
 }
 
 /*
@@ -7688,7 +7797,13 @@ next_search_hl(
 	 * 3. Vi compatible searching: continue at end of previous match.
 	 */
 	if (shl->lnum == 0)
+	{
+	    /* The search match index may tell there is no match. */
+	    if (shl == &search_hl && shl->rm.regprog != NULL
+		    && search_index_skip_line(shl->buf, lnum, shl->rm.rmm_ic))
+		break;
 	    matchcol = 0;
+	}
 	else if (vim_strchr(p_cpo, CPO_SEARCH) == NULL
 		|| (shl->rm.endpos[0].lnum == 0
 		    && shl->rm.endpos[0].col <= shl->rm.startpos[0].col))
@@ -10880,3 +10995,309 @@ screen_screenrow(void)
 {
     return screen_cur_row;
 }
+
+#if defined(FEAT_PROFILE) || defined(PROTO)
+/*
+ * ":redrawprofile": measure the time spent in the parts of a screen update.
+ * The times of an item include the items called from it, e.g. win_line()
+ * includes the syntax highlighting of the line.
+ */
+#define RDP_HIST_LEN	24	/* buckets per histogram */
+#define RDP_REDRAWS	100	/* number of screen updates kept */
+
+typedef struct
+{
+    proftime_T	total;			/* total time spent */
+    proftime_T	slowest;		/* longest time for one call */
+    long	count;			/* number of calls */
+    long	hist[RDP_HIST_LEN];	/* number of calls per duration */
+} rdp_item_T;
+
+/* Time spent per item in one screen update. */
+typedef struct
+{
+    proftime_T	time[RDP_COUNT];
+    long	count[RDP_COUNT];
+} rdp_redraw_T;
+
+static char *rdp_names[RDP_COUNT] = {"redraw", "win_update", "win_line",
+	 "fold_line", "search_hl", "syntax", "screen_line", "out_flush"};
+
+static int	    redraw_prof_on = FALSE;	/* ":redrawprofile on" used */
+static rdp_item_T   redraw_prof_items[RDP_COUNT];
+static rdp_redraw_T redraw_prof_list[RDP_REDRAWS]; /* last screen updates */
+static int	    redraw_prof_idx = 0;	/* next in redraw_prof_list[] */
+static long	    redraw_prof_count = 0;	/* screen updates measured */
+static rdp_redraw_T redraw_prof_cur;		/* current screen update */
+static proftime_T   redraw_prof_tm;		/* start of screen update */
+static int	    redraw_prof_depth = 0;	/* nested screen updates */
+
+/*
+ * ":redrawprofile {on,off,clear,report}" and ":redrawprofile dump {fname}".
+ */
+    void
+ex_redrawprofile(exarg_T *eap)
+{
+    char_u	*fname;
+
+    if (STRCMP(eap->arg, "on") == 0)
+	redraw_prof_on = TRUE;
+    else if (STRCMP(eap->arg, "off") == 0)
+    {
+	redraw_prof_on = FALSE;
+	redraw_prof_flush = FALSE;
+    }
+    else if (STRCMP(eap->arg, "clear") == 0)
+	redraw_prof_clear();
+    else if (STRCMP(eap->arg, "report") == 0)
+	redraw_prof_report();
+    else if (STRNCMP(eap->arg, "dump", 4) == 0 && vim_iswhite(eap->arg[4]))
+    {
+	fname = expand_env_save_opt(skipwhite(eap->arg + 4), TRUE);
+	if (fname != NULL)
+	{
+	    redraw_prof_dump(fname);
+	    vim_free(fname);
+	}
+    }
+    else
+	EMSG2(_(e_invarg2), eap->arg);
+}
+
+/*
+ * Called when starting to update the screen.  A nested call is part of the
+ * screen update that is already being measured.
+ */
+    static void
+redraw_prof_begin(void)
+{
+    if (redraw_prof_depth++ > 0 || !redraw_prof_on)
+	return;
+    vim_memset(&redraw_prof_cur, 0, sizeof(redraw_prof_cur));
+    redraw_prof_active = TRUE;
+    redraw_prof_flush = FALSE;
+    profile_start(&redraw_prof_tm);
+}
+
+/*
+ * Called when done updating the screen.
+ */
+    static void
+redraw_prof_finish(void)
+{
+    if (--redraw_prof_depth > 0 || !redraw_prof_active)
+	return;
+    redraw_prof_end(RDP_REDRAW, &redraw_prof_tm);
+    redraw_prof_active = FALSE;
+    redraw_prof_list[redraw_prof_idx] = redraw_prof_cur;
+    redraw_prof_idx = (redraw_prof_idx + 1) % RDP_REDRAWS;
+    ++redraw_prof_count;
+    /* Most of the output is sent to the terminal by the next out_flush(),
+     * which is done after the screen update has ended. */
+    redraw_prof_flush = TRUE;
+}
+
+/*
+ * Add the time since "tm" was set with profile_start() to item "item".
+ */
+    void
+redraw_prof_end(int item, proftime_T *tm)
+{
+    profile_end(tm);
+    redraw_prof_add(item, tm);
+}
+
+/*
+ * Add duration "tm" to item "item".  When no screen update is being measured
+ * this is the out_flush() after it, which is charged to the last one.
+ */
+    static void
+redraw_prof_add(int item, proftime_T *tm)
+{
+    rdp_item_T	*ip = &redraw_prof_items[item];
+    rdp_redraw_T *rp = &redraw_prof_cur;
+
+    if (!redraw_prof_active)
+    {
+	rp = &redraw_prof_list[(redraw_prof_idx + RDP_REDRAWS - 1)
+								% RDP_REDRAWS];
+	redraw_prof_flush = FALSE;
+    }
+    profile_add(&ip->total, tm);
+    if (profile_cmp(tm, &ip->slowest) < 0)
+	ip->slowest = *tm;
+    ++ip->count;
+    ++ip->hist[redraw_prof_bucket(tm)];
+    profile_add(&rp->time[item], tm);
+    ++rp->count[item];
+}
+
+/*
+ * Return the histogram bucket for duration "tm": bucket "i" counts the times
+ * below 2 ^ "i" microseconds, the last one everything longer.
+ */
+    static int
+redraw_prof_bucket(proftime_T *tm)
+{
+    long	usec;
+    int		i;
+# ifdef WIN3264
+    static LARGE_INTEGER fr;
+
+    if (fr.QuadPart == 0)
+	QueryPerformanceFrequency(&fr);
+    if (tm->QuadPart >= fr.QuadPart * 1000)
+	usec = 1000000000L;
+    else
+	usec = (long)(tm->QuadPart * 1000000 / fr.QuadPart);
+# else
+    if (tm->tv_sec >= 1000)
+	usec = 1000000000L;
+    else
+	usec = (long)tm->tv_sec * 1000000L + (long)tm->tv_usec;
+# endif
+    for (i = 0; i < RDP_HIST_LEN - 1 && usec >= (1L << i); ++i)
+	;
+    return i;
+}
+
+    static void
+redraw_prof_clear(void)
+{
+    vim_memset(redraw_prof_items, 0, sizeof(redraw_prof_items));
+    vim_memset(redraw_prof_list, 0, sizeof(redraw_prof_list));
+    redraw_prof_idx = 0;
+    redraw_prof_count = 0;
+    redraw_prof_flush = FALSE;
+}
+
+/*
+ * ":redrawprofile report": list the time per item and a histogram of the
+ * time used for a screen update.
+ */
+    static void
+redraw_prof_report(void)
+{
+    rdp_item_T	*ip;
+    int		i;
+    long	max = 0;
+    int		len;
+
+    MSG_PUTS_TITLE(_("  TOTAL      COUNT        SLOWEST     AVERAGE   NAME"));
+    for (i = 0; i < RDP_COUNT && !got_int; ++i)
+    {
+	ip = &redraw_prof_items[i];
+	if (ip->count == 0)
+	    continue;
+	MSG_PUTS("\n");
+	MSG_PUTS(profile_msg(&ip->total));
+	MSG_PUTS(" ");
+	msg_advance(13);
+	msg_outnum(ip->count);
+	MSG_PUTS(" ");
+	msg_advance(24);
+	MSG_PUTS(profile_msg(&ip->slowest));
+	MSG_PUTS(" ");
+	msg_advance(36);
+# ifdef FEAT_FLOAT
+	vim_snprintf((char *)IObuff, IOSIZE, "%10.6f",
+				      profile_float(&ip->total) / ip->count);
+	MSG_PUTS(IObuff);
+	MSG_PUTS(" ");
+# endif
+	msg_advance(48);
+	MSG_PUTS(rdp_names[i]);
+    }
+
+    /* Histogram of the screen update time, with a bar of up to 40 chars. */
+    ip = &redraw_prof_items[RDP_REDRAW];
+    for (i = 0; i < RDP_HIST_LEN; ++i)
+	if (ip->hist[i] > max)
+	    max = ip->hist[i];
+    if (max > 0 && !got_int)
+    {
+	MSG_PUTS("\n\n");
+	MSG_PUTS_TITLE(_("UPDATE TIME      COUNT"));
+	for (i = 0; i < RDP_HIST_LEN && !got_int; ++i)
+	{
+	    if (ip->hist[i] == 0)
+		continue;
+	    if (i == RDP_HIST_LEN - 1)
+		vim_snprintf((char *)IObuff, IOSIZE, "\n>= %ld us",
+							1L << (i - 1));
+	    else
+		vim_snprintf((char *)IObuff, IOSIZE, "\n < %ld us", 1L << i);
+	    MSG_PUTS(IObuff);
+	    msg_advance(13);
+	    msg_outnum(ip->hist[i]);
+	    msg_advance(24);
+	    len = (int)((ip->hist[i] * 40 + max - 1) / max);
+	    vim_memset(IObuff, '#', (size_t)len);
+	    IObuff[len] = NUL;
+	    MSG_PUTS(IObuff);
+	}
+    }
+    MSG_PUTS("\n");
+    vim_snprintf((char *)IObuff, IOSIZE, _("%ld screen updates measured"),
+							   redraw_prof_count);
+    MSG_PUTS(IObuff);
+}
+
+/*
+ * ":redrawprofile dump {fname}": write the measurements to "fname" in JSON
+ * format, including the items of the last RDP_REDRAWS screen updates.
+ */
+    static void
+redraw_prof_dump(char_u *fname)
+{
+    FILE	*fd;
+    rdp_item_T	*ip;
+    rdp_redraw_T *rp;
+    int		i;
+    int		j;
+    int		n;
+
+    fd = mch_fopen((char *)fname, "w");
+    if (fd == NULL)
+    {
+	EMSG2(_(e_notopen), fname);
+	return;
+    }
+
+    fprintf(fd, "{\n  \"items\": {");
+    for (i = 0; i < RDP_COUNT; ++i)
+    {
+	ip = &redraw_prof_items[i];
+	fprintf(fd, "%s\n    \"%s\": {\"total\": %s", i == 0 ? "" : ",",
+		rdp_names[i], skipwhite((char_u *)profile_msg(&ip->total)));
+	fprintf(fd, ", \"count\": %ld, \"slowest\": %s, \"histogram\": [",
+		ip->count, skipwhite((char_u *)profile_msg(&ip->slowest)));
+	for (j = 0; j < RDP_HIST_LEN; ++j)
+	    fprintf(fd, "%s%ld", j == 0 ? "" : ", ", ip->hist[j]);
+	fprintf(fd, "]}");
+    }
+
+    /* Upper limit of the histogram buckets, except the last one. */
+    fprintf(fd, "\n  },\n  \"histogram_usec\": [");
+    for (j = 0; j < RDP_HIST_LEN - 1; ++j)
+	fprintf(fd, "%s%ld", j == 0 ? "" : ", ", 1L << j);
+
+    /* The screen updates, oldest first: [seconds, count] for each item. */
+    fprintf(fd, "],\n  \"redraws\": [");
+    n = redraw_prof_count < RDP_REDRAWS ? (int)redraw_prof_count
+								: RDP_REDRAWS;
+    for (j = 0; j < n; ++j)
+    {
+	rp = &redraw_prof_list[(redraw_prof_idx - n + j + RDP_REDRAWS)
+								% RDP_REDRAWS];
+	fprintf(fd, "%s\n    {", j == 0 ? "" : ",");
+	for (i = 0; i < RDP_COUNT; ++i)
+	    fprintf(fd, "%s\"%s\": [%s, %ld]", i == 0 ? "" : ", ",
+		    rdp_names[i], skipwhite((char_u *)profile_msg(&rp->time[i])),
+		    rp->count[i]);
+	fprintf(fd, "}");
+    }
+    fprintf(fd, "\n  ]\n}\n");
+    fclose(fd);
+}
+#endif
@@ -26,13 +26,20 @@ static void back_in_line(void);
 static void find_first_blank(pos_T *);
 static void findsent_forward(long count, int at_start_sent);
 #endif
-#ifdef FEAT_FIND_ID
-static void show_pat_in_path(char_u *, int,
-					 int, int, FILE *, linenr_T *, long);
-#endif
 #ifdef FEAT_VIMINFO
 static void wvsp_one(FILE *fp, int idx, char *s, int sc);
 #endif
+#ifdef FEAT_SEARCH_EXTRA
+static int sidx_pat_ok(char_u *pat);
+static searchidx_T *sidx_find(buf_T *buf, char_u *pat, int magic, int ic);
+static int sidx_lookup(searchidx_T *si, linenr_T lnum, colnr_T col);
+static int sidx_replace(searchidx_T *si, int idx, int len, lpos_T *newpos, int newlen);
+static void sidx_truncate(searchidx_T *si, linenr_T lnum);
+static int sidx_search_line(buf_T *buf, regmmatch_T *rmp, linenr_T lnum, garray_T *gap);
+static searchidx_T *sidx_get(buf_T *buf, char_u *pat, int magic, int ic, long msec);
+static linenr_T sidx_next_line(searchidx_T *si, linenr_T lnum, int dir);
+static void search_stat(int dirc, pos_T *pos, pos_T *cursor, char_u *msgbuf);
+#endif
 
 /*
  * This file contains various searching-related routines. These fall into
@@ -111,18 +118,109 @@ static char_u	    *mr_pattern = NULL;	/* pattern used by search_regcomp() */
 static int	    mr_pattern_alloced = FALSE; /* mr_pattern was allocated */
 #endif
 
+#ifdef FEAT_SEARCH_EXTRA
+/* pattern, 'magic' and ignore-case flag last compiled by search_regcomp() */
+static char_u	    *sidx_cur_pat = NULL;
+static int	    sidx_cur_magic;
+static int	    sidx_cur_ic;
+
+/*
+ * Matches of the last search pattern in one line.  To find the last match
+ * before the cursor, or the first match after it, all matches in the line
+ * are found from the start of the line.  Remembering them avoids doing that
+ * again for every "n" or "N" in a long line.
+ */
+typedef struct
+{
+    colnr_T	lm_start;	/* start column of the match */
+    colnr_T	lm_end;		/* end column of the match */
+    colnr_T	lm_next;	/* column to search for the next match, MAXCOL
+				   when there is none */
+    int		lm_next_zero;	/* next match would be searched for in column
+				   zero, also in an empty line */
+    int		lm_submatch;	/* what first_submatch() returned */
+} linematch_T;
+
+static struct
+{
+    int		lm_fnum;	/* buffer number, zero when not valid */
+    linenr_T	lm_lnum;	/* line number */
+    int		lm_changedtick;	/* b_changedtick of the buffer */
+    char_u	*lm_pat;	/* the pattern */
+    int		lm_magic;	/* 'magic' used for "lm_pat" */
+    int		lm_ic;		/* ignoring case for "lm_pat" */
+    char_u	*lm_cpo;	/* 'cpoptions' used */
+    char_u	*lm_isk;	/* 'iskeyword' used */
+    garray_T	lm_matches;	/* linematch_T items, in the found order */
+} line_matches = {0, 0, 0, NULL, 0, 0, NULL, NULL, {0, 0, 0, 0, NULL}};
+
+static int lm_add(buf_T *buf, regmmatch_T *rmp);
+static linematch_T *lm_get(win_T *win, buf_T *buf, regmmatch_T *rmp, int idx, proftime_T *tm);
+static int search_line_matches(win_T *win, buf_T *buf, regmmatch_T *rmp, linenr_T lnum, int dir, int all, int at_end, int limit, int start, proftime_T *tm, int *submatch);
+#endif
+
 #ifdef FEAT_FIND_ID
+/*
+ * Included files read by find_pattern_in_path() are kept in memory, so that
+ * using "[I" or CTRL-X CTRL-I again does not read them again.  An entry is
+ * used as long as the file has the same size and timestamp.  The lines that
+ * match 'include' are remembered, a file without the searched text only needs
+ * to have those lines checked.
+ */
+typedef struct inclfile_S
+{
+    time_t	if_mtime;	/* timestamp of the file when read */
+    off_T	if_size;	/* size of the file when read */
+    char_u	*if_text;	/* the lines, each ending in a NUL */
+    long	if_len;		/* number of bytes in if_text */
+    int		if_count;	/* number of lines */
+    long	*if_lines;	/* offset of each line in if_text */
+    char_u	*if_inc;	/* 'magic', 'iskeyword' and 'include' used
+				   for if_incl or NULL */
+    garray_T	if_incl;	/* indexes of lines matching 'include' */
+    struct inclfile_S *if_stale; /* next entry in incl_cache_stale */
+    char_u	if_name[1];	/* full file name, actually longer */
+} inclfile_T;
+
+#define IF_KEY_OFF	offsetof(inclfile_T, if_name)
+#define HI2IF(hi)	((inclfile_T *)((hi)->hi_key - IF_KEY_OFF))
+#define INCL_CACHE_MAX	(64L * 1024L * 1024L)	/* max bytes of text kept */
+
+static hashtab_T    incl_cache;		/* inclfile_T entries by name */
+static int	    incl_cache_init = FALSE;
+static long	    incl_cache_size = 0;  /* bytes in all if_text */
+static int	    incl_cache_busy = 0;  /* find_pattern_in_path() depth */
+static inclfile_T   *incl_cache_stale = NULL; /* removed while busy */
+
 /*
  * Type used by find_pattern_in_path() to remember which included files have
  * been searched already.
  */
 typedef struct SearchedFile
 {
-    FILE	*fp;		/* File pointer */
+    inclfile_T	*inc;		/* text of the file */
+    int		idx;		/* index of the next line to read */
+    int		incl_only;	/* only lines matching 'include' matter */
+    int		incl_next;	/* index in inc->if_incl of the next one */
     char_u	*name;		/* Full name of file */
     linenr_T	lnum;		/* Line we were up to in file */
     int		matched;	/* Found a match in this file */
+#ifdef UNIX
+    dev_t	dev;		/* device of the file */
+    ino_t	ino;		/* inode of the file */
+#endif
 } SearchedFile;
+
+static void show_pat_in_path(char_u *, int,
+				 int, int, SearchedFile *, linenr_T *, long);
+static void incl_cache_free(inclfile_T *inc);
+static void incl_cache_drop(inclfile_T *inc);
+static void incl_cache_free_stale(void);
+static void incl_cache_clear(void);
+static inclfile_T *incl_cache_get(char_u *fname);
+static int incl_find_includes(inclfile_T *inc, char_u *inc_opt, regmatch_T *rmp);
+static int incl_has_text(inclfile_T *inc, char_u *ptr, int len, int ic);
+static int incl_getline(SearchedFile *sf, char_u *buf);
 #endif
 
 /*
@@ -220,6 +318,11 @@ search_regcomp(
 
     regmatch->rmm_ic = ignorecase(pat);
     regmatch->rmm_maxcol = 0;
+#ifdef FEAT_SEARCH_EXTRA
+    sidx_cur_pat = pat;
+    sidx_cur_magic = magic;
+    sidx_cur_ic = regmatch->rmm_ic;
+#endif
     regmatch->regprog = vim_regcomp(pat, magic ? RE_MAGIC : 0);
     if (regmatch->regprog == NULL)
 	return FAIL;
@@ -357,6 +460,16 @@ free_search_patterns(void)
 	mr_pattern = NULL;
     }
 # endif
+# ifdef FEAT_SEARCH_EXTRA
+    line_matches.lm_fnum = 0;
+    vim_free(line_matches.lm_pat);
+    vim_free(line_matches.lm_cpo);
+    vim_free(line_matches.lm_isk);
+    ga_clear(&line_matches.lm_matches);
+# endif
+# ifdef FEAT_FIND_ID
+    incl_cache_clear();
+# endif
 }
 #endif
 
@@ -561,6 +674,691 @@ last_pat_prog(regmmatch_T *regmatch)
 }
 #endif
 
+#if defined(FEAT_SEARCH_EXTRA) || defined(PROTO)
+/*
+ * Search match index.
+ *
+ * For every buffer the start positions of the matches of one search pattern
+ * can be remembered in b_sidx.  It is built when the match count is shown for
+ * "n" and "N", a bit at a time.  Text changes update it: changed lines are
+ * marked dirty and searched again the next time, lines below are shifted.
+ * Searching and 'hlsearch' highlighting use it to skip lines without a match.
+ *
+ * Only patterns that cannot match across lines and do not depend on the
+ * window, the cursor, marks or line numbers are indexed.  Whether a line
+ * matches then only depends on the text of that line.
+ */
+
+#define SIDX_MSEC	    100L    /* time to spend on building the index */
+#define SIDX_DIRTY_MAX	    500	    /* max nr of changed lines to search again */
+#define SIDX_MAX_MATCHES    100000  /* max nr of matches to remember */
+
+/*
+ * Return TRUE if a match of "pat" always starts and ends in one line and only
+ * depends on the text of that line.  This is conservative: some patterns
+ * that would be fine are rejected.
+ */
+    static int
+sidx_pat_ok(char_u *pat)
+{
+    char_u	*p;
+
+    for (p = pat; *p != NUL; ++p)
+    {
+	if (*p == '~')
+	    return FALSE;
+	if (*p != '\\')
+	    continue;
+	switch (*++p)
+	{
+	    case NUL:
+		return TRUE;
+	    case '~': case 'n': case '_': case '@': case 'v':
+	    case 'i': case 'I': case 'f': case 'F': case 'p': case 'P':
+		return FALSE;
+	    case 'z':
+		if (p[1] != 's' && p[1] != 'e')
+		    return FALSE;
+		++p;
+		break;
+	    case '%':
+		if (vim_strchr((char_u *)"([dxouUC", p[1]) != NULL)
+		    break;
+		/* Only "\%23c", "\%<23c" and "\%>23c", not "\%23l", etc. */
+		++p;
+		if (*p == '<' || *p == '>')
+		    ++p;
+		if (!VIM_ISDIGIT(*p))
+		    return FALSE;
+		while (VIM_ISDIGIT(p[1]))
+		    ++p;
+		if (*++p != 'c')
+		    return FALSE;
+		break;
+	}
+    }
+    return TRUE;
+}
+
+/*
+ * Free the match index of "buf".
+ */
+    void
+search_index_free(buf_T *buf)
+{
+    searchidx_T	*si = &buf->b_sidx;
+
+    vim_free(si->si_pat);
+    si->si_pat = NULL;
+    vim_free(si->si_cpo);
+    si->si_cpo = NULL;
+    vim_free(si->si_isk);
+    si->si_isk = NULL;
+    ga_clear(&si->si_pos);
+}
+
+/*
+ * Return the match index of "buf" if it is for pattern "pat" with the current
+ * options and the text did not change since it was updated.
+ * Return NULL otherwise.
+ */
+    static searchidx_T *
+sidx_find(buf_T *buf, char_u *pat, int magic, int ic)
+{
+    searchidx_T	*si = &buf->b_sidx;
+
+    if (si->si_pat == NULL || pat == NULL
+	    || si->si_changedtick != buf->b_changedtick
+	    || si->si_magic != magic
+	    || si->si_ic != ic
+	    || STRCMP(si->si_pat, pat) != 0
+	    || STRCMP(si->si_cpo, p_cpo) != 0
+	    || STRCMP(si->si_isk, buf->b_p_isk) != 0)
+	return NULL;
+    return si;
+}
+
+/*
+ * Return the index in "si" of the first match at or after "lnum" and "col".
+ */
+    static int
+sidx_lookup(searchidx_T *si, linenr_T lnum, colnr_T col)
+{
+    lpos_T	*pos = (lpos_T *)si->si_pos.ga_data;
+    int		lo = 0;
+    int		hi = si->si_pos.ga_len;
+    int		mid;
+
+    while (lo < hi)
+    {
+	mid = (lo + hi) / 2;
+	if (pos[mid].lnum < lnum
+		|| (pos[mid].lnum == lnum && pos[mid].col < col))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * Replace the "len" matches at index "idx" of "si" with the "newlen" matches
+ * in "newpos".
+ * Returns FAIL when out of memory.
+ */
+    static int
+sidx_replace(
+    searchidx_T	*si,
+    int		idx,
+    int		len,
+    lpos_T	*newpos,
+    int		newlen)
+{
+    lpos_T	*pos;
+
+    if (newlen > len && ga_grow(&si->si_pos, newlen - len) == FAIL)
+	return FAIL;
+    pos = (lpos_T *)si->si_pos.ga_data;
+    if (newlen != len)
+	mch_memmove(pos + idx + newlen, pos + idx + len,
+		     (size_t)(si->si_pos.ga_len - idx - len) * sizeof(lpos_T));
+    if (newlen > 0)
+	mch_memmove(pos + idx, newpos, (size_t)newlen * sizeof(lpos_T));
+    si->si_pos.ga_len += newlen - len;
+    return OK;
+}
+
+/*
+ * Forget about the matches in line "lnum" and below.
+ */
+    static void
+sidx_truncate(searchidx_T *si, linenr_T lnum)
+{
+    si->si_pos.ga_len = sidx_lookup(si, lnum, 0);
+    if (si->si_done >= lnum)
+	si->si_done = lnum - 1;
+    si->si_dirty_top = 0;
+}
+
+/*
+ * Add the start positions of all matches of "rmp" in line "lnum" to "gap".
+ * Continues after a match like searchit() does, depending on 'cpoptions'.
+ * Returns FAIL for an error or when interrupted, nothing is added then.
+ */
+    static int
+sidx_search_line(
+    buf_T	*buf,
+    regmmatch_T	*rmp,
+    linenr_T	lnum,
+    garray_T	*gap)
+{
+    int		len = gap->ga_len;
+    colnr_T	col = 0;
+    char_u	*ptr;
+    lpos_T	*lp;
+
+    while (vim_regexec_multi(rmp, NULL, buf, lnum, col, NULL) > 0)
+    {
+	if (called_emsg || rmp->startpos[0].lnum != 0
+		|| rmp->endpos[0].lnum != 0 || ga_grow(gap, 1) == FAIL)
+	{
+	    gap->ga_len = len;
+	    return FAIL;
+	}
+	lp = (lpos_T *)gap->ga_data + gap->ga_len++;
+	lp->lnum = lnum;
+	lp->col = rmp->startpos[0].col;
+
+	/* Continue at the end of the match when vi-compatible, otherwise one
+	 * character further.  Also for an empty match. */
+	ptr = ml_get_buf(buf, lnum, FALSE);
+	if (vim_strchr(p_cpo, CPO_SEARCH) != NULL
+				  && rmp->endpos[0].col > rmp->startpos[0].col)
+	    col = rmp->endpos[0].col;
+	else
+	{
+	    col = rmp->startpos[0].col;
+	    if (ptr[col] == NUL)
+		break;
+	    col += MB_PTR2LEN(ptr + col);
+	}
+	if (ptr[col] == NUL)
+	    break;
+    }
+    if (called_emsg || got_int)
+    {
+	gap->ga_len = len;
+	return FAIL;
+    }
+    return OK;
+}
+
+/*
+ * Get the match index of "buf" for pattern "pat", creating or updating it.
+ * When "msec" is not zero stop searching after about that time, the index is
+ * then incomplete and will be extended by the next call.
+ * Returns NULL when the pattern can't be indexed or on error.
+ */
+    static searchidx_T *
+sidx_get(buf_T *buf, char_u *pat, int magic, int ic, long msec UNUSED)
+{
+    searchidx_T	*si = &buf->b_sidx;
+    regmmatch_T	regmatch;
+    garray_T	ga;
+    int		save_called_emsg = called_emsg;
+    int		idx;
+#ifdef FEAT_RELTIME
+    proftime_T	tm;
+#endif
+
+    if (pat == NULL || !sidx_pat_ok(pat))
+	return NULL;
+    if (sidx_find(buf, pat, magic, ic) == NULL)
+    {
+	search_index_free(buf);
+	si->si_pat = vim_strsave(pat);
+	si->si_cpo = vim_strsave(p_cpo);
+	si->si_isk = vim_strsave(buf->b_p_isk);
+	if (si->si_pat == NULL || si->si_cpo == NULL || si->si_isk == NULL)
+	{
+	    search_index_free(buf);
+	    return NULL;
+	}
+	si->si_magic = magic;
+	si->si_ic = ic;
+	si->si_changedtick = buf->b_changedtick;
+	ga_init2(&si->si_pos, (int)sizeof(lpos_T), 100);
+	si->si_done = 0;
+	si->si_dirty_top = 0;
+    }
+    if (si->si_done == buf->b_ml.ml_line_count && si->si_dirty_top == 0)
+	return si;
+
+    regmatch.regprog = vim_regcomp(pat, magic ? RE_MAGIC : 0);
+    if (regmatch.regprog == NULL)
+	return NULL;
+    regmatch.rmm_ic = ic;
+    regmatch.rmm_maxcol = 0;
+#ifdef FEAT_RELTIME
+    if (msec > 0)
+	profile_setlimit(msec, &tm);
+#endif
+    called_emsg = FALSE;
+
+    /* Search the changed lines again.  When there are too many just forget
+     * about the matches from there on. */
+    if (si->si_dirty_top != 0)
+    {
+	linenr_T    lnum = si->si_dirty_top;
+
+	ga_init2(&ga, (int)sizeof(lpos_T), 10);
+	if (si->si_dirty_bot - lnum <= SIDX_DIRTY_MAX)
+	    for ( ; lnum < si->si_dirty_bot; ++lnum)
+		if (sidx_search_line(buf, &regmatch, lnum, &ga) == FAIL)
+		    break;
+	if (lnum < si->si_dirty_bot)
+	    sidx_truncate(si, si->si_dirty_top);
+	else
+	{
+	    idx = sidx_lookup(si, si->si_dirty_top, 0);
+	    if (sidx_replace(si, idx,
+			sidx_lookup(si, si->si_dirty_bot, 0) - idx,
+			(lpos_T *)ga.ga_data, ga.ga_len) == FAIL)
+		sidx_truncate(si, si->si_dirty_top);
+	    si->si_dirty_top = 0;
+	}
+	ga_clear(&ga);
+    }
+
+    while (si->si_done < buf->b_ml.ml_line_count
+				   && si->si_pos.ga_len < SIDX_MAX_MATCHES)
+    {
+#ifdef FEAT_RELTIME
+	if (msec > 0 && profile_passed_limit(&tm))
+	    break;
+#endif
+	if (sidx_search_line(buf, &regmatch, si->si_done + 1,
+							&si->si_pos) == FAIL)
+	    break;
+	++si->si_done;
+	line_breakcheck();
+	if (got_int)
+	    break;
+    }
+
+    vim_regfree(regmatch.regprog);
+    called_emsg |= save_called_emsg;
+    return si;
+}
+
+/*
+ * Called when lines "lnum" to "lnume" (exclusive) of "buf" changed and
+ * "xtra" lines were inserted below them (negative when deleted).
+ * Updates the match index, as changed_lines_buf() does for b_mod_top.
+ */
+    void
+search_index_changed(
+    buf_T	*buf,
+    linenr_T	lnum,
+    linenr_T	lnume,
+    long	xtra)
+{
+    searchidx_T	*si = &buf->b_sidx;
+    lpos_T	*pos;
+    int		idx;
+    int		i;
+
+    if (si->si_pat == NULL)
+	return;
+    /* changed() was already called.  When the index was out of date before
+     * this change it will be rebuilt. */
+    if (si->si_changedtick != buf->b_changedtick - 1)
+	return;
+    si->si_changedtick = buf->b_changedtick;
+    if (lnum > si->si_done)
+	return;
+
+    /* Drop the matches in the changed lines, shift the ones below. */
+    idx = sidx_lookup(si, lnum, 0);
+    (void)sidx_replace(si, idx, sidx_lookup(si, lnume, 0) - idx, NULL, 0);
+    if (xtra != 0)
+    {
+	pos = (lpos_T *)si->si_pos.ga_data;
+	for (i = idx; i < si->si_pos.ga_len; ++i)
+	    pos[i].lnum += xtra;
+    }
+
+    if (si->si_dirty_top != 0)
+    {
+	if (lnum < si->si_dirty_top)
+	    si->si_dirty_top = lnum;
+	if (lnum < si->si_dirty_bot)
+	{
+	    si->si_dirty_bot += xtra;
+	    if (si->si_dirty_bot < lnum)
+		si->si_dirty_bot = lnum;
+	}
+	if (lnume + xtra > si->si_dirty_bot)
+	    si->si_dirty_bot = lnume + xtra;
+    }
+    else
+    {
+	si->si_dirty_top = lnum;
+	si->si_dirty_bot = lnume + xtra;
+    }
+
+    if (si->si_done >= lnume)
+	si->si_done += xtra;
+    else
+	si->si_done = lnum - 1;
+    if (si->si_dirty_bot > si->si_done + 1)
+	si->si_dirty_bot = si->si_done + 1;
+    if (si->si_dirty_top >= si->si_dirty_bot)
+	si->si_dirty_top = 0;
+}
+
+/*
+ * Return "lnum" when the index "si" does not tell that line "lnum" has no
+ * match.  Otherwise return the next line in direction "dir" that may have a
+ * match, which may be zero or below the last line.
+ */
+    static linenr_T
+sidx_next_line(searchidx_T *si, linenr_T lnum, int dir)
+{
+    lpos_T	*pos = (lpos_T *)si->si_pos.ga_data;
+    int		idx;
+    linenr_T	next;
+
+    if (lnum > si->si_done || (si->si_dirty_top != 0
+		   && lnum >= si->si_dirty_top && lnum < si->si_dirty_bot))
+	return lnum;
+    idx = sidx_lookup(si, lnum, 0);
+    if (idx < si->si_pos.ga_len && pos[idx].lnum == lnum)
+	return lnum;
+    if (dir == FORWARD)
+    {
+	next = idx < si->si_pos.ga_len ? pos[idx].lnum : si->si_done + 1;
+	if (si->si_dirty_top > lnum && si->si_dirty_top < next)
+	    next = si->si_dirty_top;
+    }
+    else
+    {
+	next = idx > 0 ? pos[idx - 1].lnum : 0;
+	if (si->si_dirty_top != 0 && si->si_dirty_bot <= lnum
+					       && si->si_dirty_bot - 1 > next)
+	    next = si->si_dirty_bot - 1;
+    }
+    return next;
+}
+
+/*
+ * Return TRUE if the match index tells that line "lnum" of "buf" has no match
+ * for the last used search pattern.  Used for 'hlsearch'.
+ */
+    int
+search_index_skip_line(buf_T *buf, linenr_T lnum, int ic)
+{
+    searchidx_T	*si;
+
+    si = sidx_find(buf, spats[last_idx].pat, spats[last_idx].magic, ic);
+    return si != NULL && sidx_next_line(si, lnum, FORWARD) != lnum;
+}
+
+/*
+ * Add the match in "rmp" to line_matches and remember where to search for
+ * the next one, like searchit() does.
+ * Returns FAIL when out of memory, line_matches is then not valid.
+ */
+    static int
+lm_add(buf_T *buf, regmmatch_T *rmp)
+{
+    linematch_T	*lm;
+    char_u	*ptr;
+
+    if (ga_grow(&line_matches.lm_matches, 1) == FAIL)
+    {
+	line_matches.lm_fnum = 0;
+	return FAIL;
+    }
+    lm = (linematch_T *)line_matches.lm_matches.ga_data
+					     + line_matches.lm_matches.ga_len++;
+    lm->lm_start = rmp->startpos[0].col;
+    lm->lm_end = rmp->endpos[0].col;
+# ifdef FEAT_EVAL
+    lm->lm_submatch = first_submatch(rmp);
+# else
+    lm->lm_submatch = 0;
+# endif
+
+    /* Continue at the end of the match when vi-compatible, otherwise one
+     * character further.  Also for an empty match. */
+    ptr = ml_get_buf(buf, line_matches.lm_lnum, FALSE);
+    if (vim_strchr(p_cpo, CPO_SEARCH) != NULL && lm->lm_end > lm->lm_start)
+	lm->lm_next = lm->lm_end;
+    else
+    {
+	lm->lm_next = lm->lm_start;
+	if (ptr[lm->lm_next] != NUL)
+	    lm->lm_next += MB_PTR2LEN(ptr + lm->lm_next);
+    }
+    /* searchit() checks for column zero before checking for the end of the
+     * line. */
+    lm->lm_next_zero = (lm->lm_next == 0);
+    if (ptr[lm->lm_next] == NUL)
+	lm->lm_next = MAXCOL;
+    return OK;
+}
+
+/*
+ * Get match "idx" from line_matches, searching for it when needed.
+ * Returns NULL when there is no such match.
+ */
+    static linematch_T *
+lm_get(
+    win_T	*win,
+    buf_T	*buf,
+    regmmatch_T	*rmp,
+    int		idx,
+    proftime_T	*tm)
+{
+    garray_T	*gap = &line_matches.lm_matches;
+    linematch_T	*lm;
+    long	nmatched;
+
+    if (idx < gap->ga_len)
+	return (linematch_T *)gap->ga_data + idx;
+    if (line_matches.lm_fnum == 0 || gap->ga_len == 0)
+	return NULL;
+    lm = (linematch_T *)gap->ga_data + gap->ga_len - 1;
+    if (lm->lm_next == MAXCOL)
+	return NULL;
+    nmatched = vim_regexec_multi(rmp, win, buf, line_matches.lm_lnum,
+							     lm->lm_next, tm);
+    if (nmatched == 0 || rmp->startpos[0].lnum != 0
+						   || rmp->endpos[0].lnum != 0)
+    {
+	/* After an error or a timeout there may be more matches. */
+	if (called_emsg || got_int
+#ifdef FEAT_RELTIME
+		|| (tm != NULL && profile_passed_limit(tm))
+#endif
+		|| nmatched != 0)
+	    line_matches.lm_fnum = 0;
+	else
+	    lm->lm_next = MAXCOL;
+	return NULL;
+    }
+    if (lm_add(buf, rmp) == FAIL)
+	return NULL;
+    return (linematch_T *)gap->ga_data + idx;
+}
+
+/*
+ * Find a match in line "lnum" using the matches found before.  "rmp" has
+ * the first match in the line.
+ * Backward: find the last match that starts before column "limit", or ends
+ * before it when "at_end" is TRUE.  When "all" is TRUE the last match in the
+ * line.
+ * Forward: find the first match that does not start before column "limit",
+ * or end before it when "at_end" is TRUE.  When "start" is TRUE a match
+ * where searching continues in column zero is accepted, like in searchit().
+ * Returns the match in "rmp" and what first_submatch() returns in
+ * "submatch".  Returns FAIL when there is no such match.
+ * Returns NOTDONE when the pattern can't be handled, the caller must do the
+ * searching.
+ */
+    static int
+search_line_matches(
+    win_T	*win,
+    buf_T	*buf,
+    regmmatch_T	*rmp,
+    linenr_T	lnum,
+    int		dir,
+    int		all,
+    int		at_end,
+    int		limit,
+    int		start,
+    proftime_T	*tm,
+    int		*submatch)
+{
+    linematch_T	*lm;
+    linematch_T	*found = NULL;
+    int		i;
+    char_u	*ptr;
+
+    if (rmp->startpos[0].lnum != 0 || rmp->endpos[0].lnum != 0
+	    || sidx_cur_pat == NULL || !sidx_pat_ok(sidx_cur_pat))
+	return NOTDONE;
+
+    if (line_matches.lm_fnum != buf->b_fnum
+	    || line_matches.lm_lnum != lnum
+	    || line_matches.lm_changedtick != buf->b_changedtick
+	    || line_matches.lm_magic != sidx_cur_magic
+	    || line_matches.lm_ic != sidx_cur_ic
+	    || STRCMP(line_matches.lm_pat, sidx_cur_pat) != 0
+	    || STRCMP(line_matches.lm_cpo, p_cpo) != 0
+	    || STRCMP(line_matches.lm_isk, buf->b_p_isk) != 0)
+    {
+	/* Start again with the first match in the line. */
+	line_matches.lm_fnum = 0;
+	if (line_matches.lm_pat == NULL
+			     || STRCMP(line_matches.lm_pat, sidx_cur_pat) != 0)
+	{
+	    vim_free(line_matches.lm_pat);
+	    line_matches.lm_pat = vim_strsave(sidx_cur_pat);
+	}
+	vim_free(line_matches.lm_cpo);
+	line_matches.lm_cpo = vim_strsave(p_cpo);
+	vim_free(line_matches.lm_isk);
+	line_matches.lm_isk = vim_strsave(buf->b_p_isk);
+	if (line_matches.lm_pat == NULL || line_matches.lm_cpo == NULL
+					       || line_matches.lm_isk == NULL)
+	    return NOTDONE;
+	line_matches.lm_lnum = lnum;
+	line_matches.lm_changedtick = buf->b_changedtick;
+	line_matches.lm_magic = sidx_cur_magic;
+	line_matches.lm_ic = sidx_cur_ic;
+	if (line_matches.lm_matches.ga_itemsize == 0)
+	    ga_init2(&line_matches.lm_matches, (int)sizeof(linematch_T), 100);
+	line_matches.lm_matches.ga_len = 0;
+	line_matches.lm_fnum = buf->b_fnum;
+	if (lm_add(buf, rmp) == FAIL)
+	    return NOTDONE;
+    }
+
+    for (i = 0; (lm = lm_get(win, buf, rmp, i, tm)) != NULL; ++i)
+    {
+	if (dir == BACKWARD)
+	{
+	    if (!all && (at_end ? (int)lm->lm_end - 1 : (int)lm->lm_start)
+								     >= limit)
+		break;
+	    found = lm;
+	}
+	else
+	{
+	    /* When the match lands on a NUL the cursor will be put one back
+	     * afterwards, compare with that position. */
+	    ptr = ml_get_buf(buf, lnum, FALSE);
+	    if ((at_end ? (int)lm->lm_end - 1
+		      : (int)lm->lm_start - (ptr[lm->lm_start] == NUL)) >= limit
+		    || (lm->lm_next_zero && start))
+	    {
+		found = lm;
+		break;
+	    }
+	}
+    }
+
+    if (found == NULL)
+	return FAIL;
+    rmp->startpos[0].lnum = 0;
+    rmp->startpos[0].col = found->lm_start;
+    rmp->endpos[0].lnum = 0;
+    rmp->endpos[0].col = found->lm_end;
+    *submatch = found->lm_submatch;
+    return OK;
+}
+
+/*
+ * Show the search command "msgbuf" with the number of the match at "pos" and
+ * the number of matches, e.g. "/foo   [3/8]".  When the index is not
+ * complete it is "[3/>8]".  "W" is added when the search wrapped around the
+ * end of the buffer, "dirc" is the search direction, "cursor" the position
+ * where the search started.
+ */
+    static void
+search_stat(int dirc, pos_T *pos, pos_T *cursor, char_u *msgbuf)
+{
+    searchidx_T	*si;
+    lpos_T	*lp;
+    int		idx;
+    char	cur[20];
+    char	stat[60];
+    int		stat_len;
+    int		width;
+    int		len;
+    char_u	*text;
+
+    si = sidx_get(curbuf, sidx_cur_pat, sidx_cur_magic, sidx_cur_ic,
+								   SIDX_MSEC);
+    if (si == NULL)
+	return;
+
+    STRCPY(cur, "?");
+    idx = sidx_lookup(si, pos->lnum, pos->col);
+    lp = (lpos_T *)si->si_pos.ga_data + idx;
+    if (idx < si->si_pos.ga_len && lp->lnum == pos->lnum
+						      && lp->col == pos->col)
+	sprintf(cur, "%d", idx + 1);
+    vim_snprintf(stat, sizeof(stat), "%s[%s/%s%d]",
+	    (dirc == '/' ? lt(*pos, *cursor) : lt(*cursor, *pos)) ? "W " : "",
+	    cur, si->si_done < curbuf->b_ml.ml_line_count ? ">" : "",
+	    si->si_pos.ga_len);
+    stat_len = (int)STRLEN(stat);
+
+    /* Put the count at the end, before the ruler and 'showcmd'.  Truncate
+     * the pattern if needed. */
+    width = sc_col - 1;
+    if (width - stat_len - 1 < 3)
+	return;
+    len = (int)STRLEN(msgbuf) * MB_MAXBYTES + 3;
+    text = alloc((unsigned)(len + width + stat_len));
+    if (text == NULL)
+	return;
+    trunc_string(msgbuf, text, width - stat_len - 1, len);
+    len = (int)STRLEN(text);
+    for (idx = vim_strsize(text); idx < width - stat_len; ++idx)
+	text[len++] = ' ';
+    STRCPY(text + len, stat);
+
+    msg_hist_off = TRUE;
+    give_warning(text, FALSE);
+    msg_hist_off = FALSE;
+    vim_free(text);
+}
+#endif
+
 /*
  * Lowest level search function.
  * Search for 'count'th occurrence of pattern 'pat' in direction 'dir'.
@@ -615,6 +1413,10 @@ searchit(
     int		save_called_emsg = called_emsg;
 #ifdef FEAT_SEARCH_EXTRA
     int		break_loop = FALSE;
+    searchidx_T	*sidx;
+    linenr_T	next_lnum;
+    int		line_found;
+    int		line_submatch;
 #endif
 
     if (search_regcomp(pat, RE_SEARCH, pat_use,
@@ -624,6 +1426,11 @@ searchit(
 	    EMSG2(_("E383: Invalid search string: %s"), mr_pattern);
 	return FAIL;
     }
+#ifdef FEAT_SEARCH_EXTRA
+    /* When the matches of the pattern are in the match index, lines without
+     * a match can be skipped. */
+    sidx = sidx_find(buf, sidx_cur_pat, sidx_cur_magic, sidx_cur_ic);
+#endif
 
     /*
      * find the string
@@ -706,6 +1513,24 @@ searchit(
 		if (tm != NULL && profile_passed_limit(tm))
 		    break;
 #endif
+#ifdef FEAT_SEARCH_EXTRA
+		if (sidx != NULL && !at_first_line
+			&& (next_lnum = sidx_next_line(sidx, lnum, dir)) != lnum)
+		{
+		    /* Stop where started in the second loop, when going past
+		     * the end or past "stop_lnum", as below. */
+		    if (loop && (dir == FORWARD
+			    ? start_pos.lnum >= lnum && start_pos.lnum < next_lnum
+			    : start_pos.lnum <= lnum && start_pos.lnum > next_lnum))
+			break;
+		    lnum = next_lnum;
+		    if (lnum <= 0 || lnum > buf->b_ml.ml_line_count)
+			break;
+		    if (stop_lnum != 0 && (dir == FORWARD
+				       ? lnum > stop_lnum : lnum < stop_lnum))
+			break;
+		}
+#endif
 
 		/*
 		 * Look for a match somewhere in line "lnum".
@@ -752,6 +1577,35 @@ searchit(
 			 * one back afterwards, compare with that position,
 			 * otherwise "/$" will get stuck on end of line.
 			 */
+#ifdef FEAT_SEARCH_EXTRA
+			/* Use the matches in this line found before, unless
+			 * searching did not start in column zero. */
+			line_found = NOTDONE;
+			if (col == 0)
+			    line_found = search_line_matches(win, buf,
+				    &regmatch, lnum, FORWARD, FALSE,
+				    (options & SEARCH_END) && first_match,
+				    (int)start_pos.col + extra_col,
+				    (options & SEARCH_START) != 0,
+# ifdef FEAT_RELTIME
+				    tm,
+# else
+				    NULL,
+# endif
+				    &line_submatch);
+			if (line_found != NOTDONE)
+			{
+			    if (line_found == OK)
+			    {
+				matchpos = regmatch.startpos[0];
+				endpos = regmatch.endpos[0];
+				submatch = line_submatch;
+			    }
+			    else
+				match_ok = FALSE;
+			}
+			else
+#endif
 			while (matchpos.lnum == 0
 				&& ((options & SEARCH_END) && first_match
 				    ?  (nmatched == 1
@@ -842,6 +1696,34 @@ searchit(
 			 * relative to the end of the match.
 			 */
 			match_ok = FALSE;
+#ifdef FEAT_SEARCH_EXTRA
+			/* Use the matches in this line found before, unless
+			 * searching did not start in column zero. */
+			line_found = NOTDONE;
+			if (col == 0)
+			    line_found = search_line_matches(win, buf,
+				    &regmatch, lnum, BACKWARD,
+				    loop || lnum < start_pos.lnum,
+				    (options & SEARCH_END) != 0,
+				    (int)start_pos.col + extra_col, FALSE,
+# ifdef FEAT_RELTIME
+				    tm,
+# else
+				    NULL,
+# endif
+				    &line_submatch);
+			if (line_found != NOTDONE)
+			{
+			    if (line_found == OK)
+			    {
+				match_ok = TRUE;
+				matchpos = regmatch.startpos[0];
+				endpos = regmatch.endpos[0];
+				submatch = line_submatch;
+			    }
+			}
+			else
+#endif
 			for (;;)
 			{
 			    /* Remember a position that is before the start
@@ -1158,6 +2040,7 @@ do_search(
     char_u	    *dircp;
     char_u	    *strcopy = NULL;
     char_u	    *ps;
+    char_u	    *msgbuf = NULL;
 
     /*
      * A line offset is not remembered, this is vi compatible.
@@ -1316,13 +2199,13 @@ do_search(
 	if ((options & SEARCH_ECHO) && messaging()
 					    && !cmd_silent && msg_silent == 0)
 	{
-	    char_u	*msgbuf;
 	    char_u	*trunc;
 
 	    if (*searchstr == NUL)
 		p = spats[last_idx].pat;
 	    else
 		p = searchstr;
+	    vim_free(msgbuf);
 	    msgbuf = alloc((unsigned)(STRLEN(p) + 40));
 	    if (msgbuf != NULL)
 	    {
@@ -1382,7 +2265,6 @@ do_search(
 		    msg_outtrans(msgbuf);
 		msg_clr_eos();
 		msg_check();
-		vim_free(msgbuf);
 
 		gotocmdline(FALSE);
 		out_flush();
@@ -1447,6 +2329,19 @@ do_search(
 
 	retval = 1;		    /* pattern found */
 
+#ifdef FEAT_SEARCH_EXTRA
+	/* Show the number of the match and the number of matches, not when
+	 * there is an offset or another search follows. */
+	if (msgbuf != NULL && !shortmess(SHM_SEARCHCOUNT)
+		&& !spats[0].off.line && !spats[0].off.end
+		&& !spats[0].off.off && (pat == NULL || *pat != ';')
+# ifdef FEAT_RIGHTLEFT
+		&& !(curwin->w_p_rl && *curwin->w_p_rlc == 's')
+# endif
+		)
+	    search_stat(dirc, &pos, &curwin->w_cursor, msgbuf);
+#endif
+
 	/*
 	 * Add character and/or line offset
 	 */
@@ -1515,6 +2410,7 @@ end_do_search:
     if ((options & SEARCH_KEEP) || cmdmod.keeppatterns)
 	spats[0].off = old_off;
     vim_free(strcopy);
+    vim_free(msgbuf);
 
     return retval;
 }
@@ -4809,6 +5705,269 @@ linewhite(linenr_T lnum)
 #endif
 
 #if defined(FEAT_FIND_ID) || defined(PROTO)
+/*
+ * Free "inc", an entry of the included file cache.
+ */
+    static void
+incl_cache_free(inclfile_T *inc)
+{
+    incl_cache_size -= inc->if_len;
+    vim_free(inc->if_text);
+    vim_free(inc->if_lines);
+    vim_free(inc->if_inc);
+    ga_clear(&inc->if_incl);
+    vim_free(inc);
+}
+
+/*
+ * Free "inc", which was removed from the included file cache.  While
+ * find_pattern_in_path() is busy its files[] may still point to it, then
+ * freeing is postponed until incl_cache_free_stale() is called.
+ */
+    static void
+incl_cache_drop(inclfile_T *inc)
+{
+    if (incl_cache_busy > 0)
+    {
+	inc->if_stale = incl_cache_stale;
+	incl_cache_stale = inc;
+    }
+    else
+	incl_cache_free(inc);
+}
+
+/*
+ * Free the entries that incl_cache_drop() postponed freeing.
+ */
+    static void
+incl_cache_free_stale(void)
+{
+    inclfile_T	*inc;
+
+    while (incl_cache_stale != NULL)
+    {
+	inc = incl_cache_stale;
+	incl_cache_stale = inc->if_stale;
+	incl_cache_free(inc);
+    }
+}
+
+/*
+ * Forget all included files kept in memory.
+ */
+    static void
+incl_cache_clear(void)
+{
+    hashitem_T	*hi;
+    int		todo;
+
+    if (!incl_cache_init)
+	return;
+    todo = (int)incl_cache.ht_used;
+    for (hi = incl_cache.ht_array; todo > 0; ++hi)
+	if (!HASHITEM_EMPTY(hi))
+	{
+	    incl_cache_drop(HI2IF(hi));
+	    --todo;
+	}
+    hash_clear(&incl_cache);
+    hash_init(&incl_cache);
+}
+
+/*
+ * Get the text of included file "fname", read it when it is not in memory
+ * yet or was changed.  Lines are truncated and have the line break removed
+ * like vim_fgets() does.
+ * Returns NULL when the file can't be read.
+ */
+    static inclfile_T *
+incl_cache_get(char_u *fname)
+{
+    stat_T	st;
+    hash_T	hash;
+    hashitem_T	*hi;
+    inclfile_T	*inc;
+    FILE	*fd;
+    long	len;
+    long	off;
+    long	end;
+    long	n;
+    int		i;
+
+    if (mch_stat((char *)fname, &st) < 0)
+	return NULL;
+    if (!incl_cache_init)
+    {
+	hash_init(&incl_cache);
+	incl_cache_init = TRUE;
+    }
+    hash = hash_hash(fname);
+    hi = hash_lookup(&incl_cache, fname, hash);
+    if (!HASHITEM_EMPTY(hi))
+    {
+	inc = HI2IF(hi);
+	if (inc->if_mtime == st.st_mtime && inc->if_size == (off_T)st.st_size)
+	    return inc;
+	hash_remove(&incl_cache, hi);
+	incl_cache_drop(inc);
+    }
+
+    fd = mch_fopen((char *)fname, READBIN);
+    if (fd == NULL)
+	return NULL;
+    inc = (inclfile_T *)alloc_clear((unsigned)(sizeof(inclfile_T)
+							    + STRLEN(fname)));
+    if (inc == NULL)
+    {
+	fclose(fd);
+	return NULL;
+    }
+    STRCPY(inc->if_name, fname);
+    inc->if_mtime = st.st_mtime;
+    inc->if_size = (off_T)st.st_size;
+    ga_init2(&inc->if_incl, (int)sizeof(int), 50);
+    inc->if_text = alloc((unsigned)st.st_size + 1);
+    if (inc->if_text == NULL)
+    {
+	fclose(fd);
+	vim_free(inc);
+	return NULL;
+    }
+    len = (long)fread(inc->if_text, 1, (size_t)st.st_size, fd);
+    fclose(fd);
+    if (len < 0)
+	len = 0;
+    inc->if_text[len] = NUL;
+    inc->if_len = len;
+
+    for (off = 0; off < len; ++off)
+	if (inc->if_text[off] == '\n')
+	    ++inc->if_count;
+    if (len > 0 && inc->if_text[len - 1] != '\n')
+	++inc->if_count;
+    inc->if_lines = (long *)alloc((unsigned)(sizeof(long)
+						 * (inc->if_count + 1)));
+    if (inc->if_lines == NULL)
+    {
+	vim_free(inc->if_text);
+	vim_free(inc);
+	return NULL;
+    }
+    off = 0;
+    for (i = 0; i < inc->if_count; ++i)
+    {
+	inc->if_lines[i] = off;
+	for (end = off; end < len && inc->if_text[end] != '\n'; ++end)
+	    ;
+	n = end - off;
+	if (n > LSIZE - 1)
+	    n = LSIZE - 1;
+	if (n > 0 && inc->if_text[off + n - 1] == '\r')
+	    --n;
+	inc->if_text[off + n] = NUL;
+	off = end + 1;
+    }
+
+    hi = hash_lookup(&incl_cache, inc->if_name, hash);
+    hash_add_item(&incl_cache, hi, inc->if_name, hash);
+    incl_cache_size += inc->if_len;
+    return inc;
+}
+
+/*
+ * Find the lines of "inc" that match 'include' "inc_opt", compiled in "rmp".
+ * Does nothing when it was done before with the same options.
+ * Returns FAIL when out of memory.
+ */
+    static int
+incl_find_includes(inclfile_T *inc, char_u *inc_opt, regmatch_T *rmp)
+{
+    char_u	*key;
+    int		i;
+
+    /* The match also depends on 'magic' and 'iskeyword'. */
+    key = alloc((unsigned)(STRLEN(inc_opt) + STRLEN(curbuf->b_p_isk) + 4));
+    if (key == NULL)
+	return FAIL;
+    sprintf((char *)key, "%d%s\n%s", p_magic ? 1 : 0, curbuf->b_p_isk,
+								     inc_opt);
+    if (inc->if_inc != NULL && STRCMP(inc->if_inc, key) == 0)
+    {
+	vim_free(key);
+	return OK;
+    }
+    vim_free(inc->if_inc);
+    inc->if_inc = NULL;
+    inc->if_incl.ga_len = 0;
+    if (rmp->regprog != NULL)
+	for (i = 0; i < inc->if_count; ++i)
+	    if (vim_regexec(rmp, inc->if_text + inc->if_lines[i], (colnr_T)0))
+	    {
+		if (ga_grow(&inc->if_incl, 1) == FAIL)
+		{
+		    vim_free(key);
+		    return FAIL;
+		}
+		((int *)inc->if_incl.ga_data)[inc->if_incl.ga_len++] = i;
+	    }
+    inc->if_inc = key;
+    return OK;
+}
+
+/*
+ * Return TRUE if the text of "inc" contains the "len" bytes at "ptr".
+ * When "ic" is TRUE ignore case, "ptr" must be ASCII then.
+ */
+    static int
+incl_has_text(inclfile_T *inc, char_u *ptr, int len, int ic)
+{
+    char_u	*p;
+    char_u	*end;
+    int		c = ic ? TOLOWER_ASC(*ptr) : *ptr;
+
+    if (inc->if_len < len)
+	return FALSE;
+    end = inc->if_text + inc->if_len - len;
+    if (!ic)
+    {
+	/* memchr() is much faster than checking each byte */
+	for (p = inc->if_text; (p = (char_u *)memchr(p, c,
+					      (size_t)(end - p + 1))) != NULL; ++p)
+	    if (STRNCMP(p, ptr, len) == 0)
+		return TRUE;
+	return FALSE;
+    }
+    for (p = inc->if_text; p <= end; ++p)
+	if (TOLOWER_ASC(*p) == c && STRNICMP(p, ptr, len) == 0)
+	    return TRUE;
+    return FALSE;
+}
+
+/*
+ * Get the next line of included file "sf" into "buf", which is LSIZE bytes.
+ * When only lines matching 'include' matter the other ones are skipped.
+ * Returns TRUE at the end of the file, like vim_fgets().
+ */
+    static int
+incl_getline(SearchedFile *sf, char_u *buf)
+{
+    inclfile_T	*inc = sf->inc;
+    int		next;
+
+    if (sf->incl_only)
+    {
+	if (sf->incl_next >= inc->if_incl.ga_len)
+	    return TRUE;
+	next = ((int *)inc->if_incl.ga_data)[sf->incl_next++];
+	sf->lnum += next - sf->idx;
+	sf->idx = next;
+    }
+    if (sf->idx >= inc->if_count)
+	return TRUE;
+    vim_strncpy(buf, inc->if_text + inc->if_lines[sf->idx++], LSIZE - 1);
+    return FALSE;
+}
+
 /*
  * Find identifiers or defines in included files.
  * If p_ic && (compl_cont_status & CONT_SOL) then ptr must be in lowercase.
@@ -4856,6 +6015,11 @@ find_pattern_in_path(
     char_u	*already = NULL;
     char_u	*startp = NULL;
     char_u	*inc_opt = NULL;
+    int		incl_only_ok;
+#ifdef UNIX
+    stat_T	st;
+    int		st_ok = FALSE;
+#endif
 #if defined(FEAT_WINDOWS) && defined(FEAT_QUICKFIX)
     win_T	*curwin_save = NULL;
 #endif
@@ -4867,6 +6031,8 @@ find_pattern_in_path(
     file_line = alloc(LSIZE);
     if (file_line == NULL)
 	return;
+    /* Cache entries that files[] points to must not be freed until the end. */
+    ++incl_cache_busy;
 
     if (type != CHECK_PATH && type != FIND_DEFINE
 #ifdef FEAT_INS_EXPAND
@@ -4908,6 +6074,27 @@ find_pattern_in_path(
     if (files == NULL)
 	goto fpip_end;
     old_files = max_path_depth;
+
+    /* A line can only match when it contains the text "ptr".  In an included
+     * file without that text only the lines matching 'include' need to be
+     * checked.  Not when "ptr" may be a pattern or case is ignored for
+     * non-ASCII text. */
+    if (type == CHECK_PATH)
+	incl_only_ok = TRUE;
+    else
+    {
+	incl_only_ok = len > 0;
+	for (i = 0; i < len && incl_only_ok; ++i)
+	    if (vim_strchr((char_u *)"\\.*[~^$", ptr[i]) != NULL
+						     || (p_ic && ptr[i] >= 0x80))
+		incl_only_ok = FALSE;
+    }
+#ifdef FEAT_INS_EXPAND
+    if (compl_cont_status & CONT_SOL)
+	incl_only_ok = FALSE;
+#endif
+    if (incl_cache_size > INCL_CACHE_MAX)
+	incl_cache_clear();
     depth = depth_displayed = -1;
 
     lnum = start_lnum;
@@ -4937,14 +6124,26 @@ find_pattern_in_path(
 	    already_searched = FALSE;
 	    if (new_fname != NULL)
 	    {
-		/* Check whether we have already searched in this file */
+		/* Check whether we have already searched in this file.
+		 * Comparing with the remembered inode avoids calling stat()
+		 * for every file searched so far. */
+#ifdef UNIX
+		st_ok = mch_stat((char *)new_fname, &st) == 0;
+#endif
 		for (i = 0;; i++)
 		{
 		    if (i == depth + 1)
 			i = old_files;
 		    if (i == max_path_depth)
 			break;
+#ifdef UNIX
+		    if (st_ok ? files[i].dev == st.st_dev
+						    && files[i].ino == st.st_ino
+			    : (fullpathcmp(new_fname, files[i].name, TRUE)
+								   & FPC_SAME))
+#else
 		    if (fullpathcmp(new_fname, files[i].name, TRUE) & FPC_SAME)
+#endif
 		    {
 			if (type != CHECK_PATH &&
 				action == ACTION_SHOW_ALL && files[i].matched)
@@ -5072,7 +6271,7 @@ find_pattern_in_path(
 			    bigger[i] = files[i];
 			for (i = depth + 1; i < old_files + max_path_depth; i++)
 			{
-			    bigger[i].fp = NULL;
+			    bigger[i].inc = NULL;
 			    bigger[i].name = NULL;
 			    bigger[i].lnum = 0;
 			    bigger[i].matched = FALSE;
@@ -5085,8 +6284,7 @@ find_pattern_in_path(
 			files = bigger;
 		    }
 		}
-		if ((files[depth + 1].fp = mch_fopen((char *)new_fname, "r"))
-								    == NULL)
+		if ((files[depth + 1].inc = incl_cache_get(new_fname)) == NULL)
 		    vim_free(new_fname);
 		else
 		{
@@ -5102,6 +6300,17 @@ find_pattern_in_path(
 		    files[depth].name = curr_fname = new_fname;
 		    files[depth].lnum = 0;
 		    files[depth].matched = FALSE;
+		    files[depth].idx = 0;
+		    files[depth].incl_next = 0;
+#ifdef UNIX
+		    files[depth].dev = st_ok ? st.st_dev : 0;
+		    files[depth].ino = st_ok ? st.st_ino : 0;
+#endif
+		    files[depth].incl_only = incl_only_ok
+			    && (type == CHECK_PATH || !incl_has_text(
+					 files[depth].inc, ptr, len, p_ic))
+			    && incl_find_includes(files[depth].inc, inc_opt,
+							 &incl_regmatch) == OK;
 #ifdef FEAT_INS_EXPAND
 		    if (action == ACTION_EXPAND)
 		    {
@@ -5256,8 +6465,7 @@ search_line:
 			    goto exit_matched;
 			line = ml_get(++lnum);
 		    }
-		    else if (vim_fgets(line = file_line,
-						      LSIZE, files[depth].fp))
+		    else if (incl_getline(&files[depth], line = file_line))
 			goto exit_matched;
 
 		    /* we read a line, set "already" to check this "line" later
@@ -5322,7 +6530,7 @@ search_line:
 		did_show = TRUE;
 		if (!got_int)
 		    show_pat_in_path(line, type, TRUE, action,
-			    (depth == -1) ? NULL : files[depth].fp,
+			    (depth == -1) ? NULL : &files[depth],
 			    (depth == -1) ? &lnum : &files[depth].lnum,
 			    match_count++);
 
@@ -5343,7 +6551,7 @@ search_line:
 		else if (action == ACTION_SHOW)
 		{
 		    show_pat_in_path(line, type, did_show, action,
-			(depth == -1) ? NULL : files[depth].fp,
+			(depth == -1) ? NULL : &files[depth],
 			(depth == -1) ? &lnum : &files[depth].lnum, 1L);
 		    did_show = TRUE;
 		}
@@ -5442,12 +6650,10 @@ exit_matched:
 	 * it.
 	 */
 	while (depth >= 0 && !already
-		&& vim_fgets(line = file_line, LSIZE, files[depth].fp))
+		&& incl_getline(&files[depth], line = file_line))
 	{
-	    fclose(files[depth].fp);
 	    --old_files;
-	    files[old_files].name = files[depth].name;
-	    files[old_files].matched = files[depth].matched;
+	    files[old_files] = files[depth];
 	    --depth;
 	    curr_fname = (depth == -1) ? curbuf->b_fname
 				       : files[depth].name;
@@ -5455,15 +6661,7 @@ exit_matched:
 		depth_displayed = depth;
 	}
 	if (depth >= 0)		/* we could read the line */
-	{
 	    files[depth].lnum++;
-	    /* Remove any CR and LF from the line. */
-	    i = (int)STRLEN(line);
-	    if (i > 0 && line[i - 1] == '\n')
-		line[--i] = NUL;
-	    if (i > 0 && line[i - 1] == '\r')
-		line[--i] = NUL;
-	}
 	else if (!already)
 	{
 	    if (++lnum > end_lnum)
@@ -5474,12 +6672,8 @@ exit_matched:
     }
     /* End of big for (;;) loop. */
 
-    /* Close any files that are still open. */
     for (i = 0; i <= depth; i++)
-    {
-	fclose(files[i].fp);
 	vim_free(files[i].name);
-    }
     for (i = old_files; i < max_path_depth; i++)
 	vim_free(files[i].name);
     vim_free(files);
@@ -5519,6 +6713,8 @@ fpip_end:
     vim_regfree(regmatch.regprog);
     vim_regfree(incl_regmatch.regprog);
     vim_regfree(def_regmatch.regprog);
+    if (--incl_cache_busy == 0)
+	incl_cache_free_stale();
 }
 
     static void
@@ -5527,7 +6723,7 @@ show_pat_in_path(
     int	    type,
     int	    did_show,
     int	    action,
-    FILE    *fp,
+    SearchedFile *sf,	    /* included file or NULL for current buffer */
     linenr_T *lnum,
     long    count)
 {
@@ -5542,15 +6738,6 @@ show_pat_in_path(
     for (;;)
     {
 	p = line + STRLEN(line) - 1;
-	if (fp != NULL)
-	{
-	    /* We used fgets(), so get rid of newline at end */
-	    if (p >= line && *p == '\n')
-		--p;
-	    if (p >= line && *p == '\r')
-		--p;
-	    *(p + 1) = NUL;
-	}
 	if (action == ACTION_SHOW_ALL)
 	{
 	    sprintf((char *)IObuff, "%3ld: ", count);	/* show match nr */
@@ -5567,9 +6754,9 @@ show_pat_in_path(
 	if (got_int || type != FIND_DEFINE || p < line || *p != '\\')
 	    break;
 
-	if (fp != NULL)
+	if (sf != NULL)
 	{
-	    if (vim_fgets(line, LSIZE, fp)) /* end of file */
+	    if (incl_getline(sf, line)) /* end of file */
 		break;
 	    ++*lnum;
 	}
@@ -454,6 +454,9 @@ typedef struct mf_hashtab_S
  * The used list is a doubly linked list, most recently used block first.
  *	The blocks in the used list have a block of memory allocated.
  *	mf_used_count is the number of pages in the used list.
+ *	A block that was used again after it was read gets a second chance
+ *	before it is released, so that reading many blocks once doesn't push
+ *	out the blocks that are used all the time.
  * The hash lists are used to quickly find a block in the used list.
  * The free list is a single linked list, not sorted.
  *	The blocks in the free list have no block of memory allocated and
@@ -472,7 +475,9 @@ struct block_hdr
 
 #define BH_DIRTY    1
 #define BH_LOCKED   2
-    char	bh_flags;	    /* BH_DIRTY or BH_LOCKED */
+#define BH_REFERENCED 4		    /* used again since it was read or last
+				       given a second chance */
+    char	bh_flags;	    /* BH_DIRTY, BH_LOCKED, BH_REFERENCED */
 };
 
 /*
@@ -595,6 +600,10 @@ struct memfile
     blocknr_T	mf_infile_count;	/* number of pages in the file */
     unsigned	mf_page_size;		/* number of bytes in a page */
     int		mf_dirty;		/* TRUE if there are dirty blocks */
+    long	mf_hit_count;		/* mf_get() found block in memory */
+    long	mf_miss_count;		/* mf_get() had to read the block */
+    long	mf_write_count;		/* number of blocks written */
+    long	mf_release_count;	/* number of blocks released */
 #ifdef FEAT_CRYPT
     buf_T	*mf_buffer;		/* buffer this memfile is for */
     char_u	mf_seed[MF_SEED_LEN];	/* seed for encryption */
@@ -623,6 +632,25 @@ typedef struct info_pointer
     int		ip_index;	/* index for block with current lnum */
 } infoptr_T;	/* block/index pair */
 
+/*
+ * ml_find_line() remembers a few data blocks it found, with the stack of
+ * pointer blocks leading to them, so that going back to a line in one of
+ * them does not need to walk the tree again.  Only valid until lines are
+ * inserted or deleted.
+ */
+#define MLCACHE_SIZE	8	/* number of data blocks remembered */
+#define MLCACHE_DEPTH	6	/* max depth of the tree for remembering */
+
+typedef struct
+{
+    blocknr_T	mc_bnum;	/* data block number */
+    int		mc_page_count;	/* number of pages in the data block */
+    linenr_T	mc_low;		/* first line in the data block */
+    linenr_T	mc_high;	/* last line in the data block */
+    int		mc_stack_top;	/* number of entries in mc_stack */
+    infoptr_T	mc_stack[MLCACHE_DEPTH]; /* copy of ml_stack */
+} mlcache_T;
+
 #ifdef FEAT_BYTEOFF
 typedef struct ml_chunksize
 {
@@ -663,10 +691,21 @@ typedef struct memline
     linenr_T	ml_locked_low;	/* first line in ml_locked */
     linenr_T	ml_locked_high;	/* last line in ml_locked */
     int		ml_locked_lineadd;  /* number of lines inserted in ml_locked */
+
+    mlcache_T	*ml_cache;	/* data blocks found recently or NULL */
+    int		ml_cache_used;	/* number of valid entries in ml_cache */
+    int		ml_cache_next;	/* entry in ml_cache to be replaced next */
+    long	ml_cache_hits;	/* lookups found in ml_cache */
+    long	ml_cache_misses; /* lookups that walked the tree */
 #ifdef FEAT_BYTEOFF
     chunksize_T *ml_chunksize;
     int		ml_numchunks;
     int		ml_usedchunks;
+    int		ml_chunks_stale;    /* ml_chunksize must be rebuilt before
+				       it is used */
+    chunksize_T *ml_chunktree;	    /* Fenwick tree with sums of chunks */
+    int		ml_chunktree_size;  /* entries allocated for ml_chunktree */
+    int		ml_chunktree_valid; /* ml_chunktree matches ml_chunksize */
 #endif
 } memline_T;
 
@@ -1757,6 +1796,13 @@ typedef struct {
 #ifdef FEAT_SYN_HL
     hashtab_T	b_keywtab;		/* syntax keywords hash table */
     hashtab_T	b_keywtab_ic;		/* idem, ignore case */
+    char_u	b_keyw_first[32];	/* bitmap of bytes a keyword can start
+					   with */
+    char_u	b_keyw_first_ic[32];	/* bitmap of first bytes of the
+					   keywords in b_keywtab_ic */
+    char_u	b_keyw_fold[256];	/* byte each byte folds to, NUL when it
+					   doesn't fold into a single byte */
+    int		b_keyw_maxlen;		/* max byte length of a keyword */
     int		b_syn_error;		/* TRUE when error occurred in HL */
     int		b_syn_ic;		/* ignore case for :syn cmds */
     int		b_syn_spell;		/* SYNSPL_ values */
@@ -1798,6 +1844,10 @@ typedef struct {
      * b_sst_freecount	number of free entries in b_sst_array[]
      * b_sst_check_lnum	entries after this lnum need to be checked for
      *			validity (MAXLNUM means no check needed)
+     * b_sst_idle_lnum	lines up to here were parsed while waiting for a
+     *			character to be typed
+     * b_sst_cache_tried	states from 'syncachedir' were loaded, or that
+     *			was tried
      */
     synstate_T	*b_sst_array;
     int		b_sst_len;
@@ -1806,6 +1856,10 @@ typedef struct {
     int		b_sst_freecount;
     linenr_T	b_sst_check_lnum;
     short_u	b_sst_lasttick;	/* last display tick */
+    linenr_T	b_sst_idle_lnum;
+# ifdef FEAT_SYN_CACHE
+    int		b_sst_cache_tried;
+# endif
 #endif /* FEAT_SYN_HL */
 
 #ifdef FEAT_SPELL
@@ -1839,6 +1893,27 @@ typedef struct {
  * A buffer is new if the associated file has never been loaded yet.
  */
 
+#ifdef FEAT_SEARCH_EXTRA
+/*
+ * Positions of the matches of a search pattern in a buffer, kept up-to-date
+ * when the text changes.  See search.c.
+ */
+typedef struct
+{
+    char_u	*si_pat;	/* pattern the index is for, NULL if none */
+    int		si_magic;	/* 'magic' used for "si_pat" */
+    int		si_ic;		/* ignoring case for "si_pat" */
+    char_u	*si_cpo;	/* 'cpoptions' used */
+    char_u	*si_isk;	/* 'iskeyword' used */
+    int		si_changedtick;	/* b_changedtick when last updated */
+    garray_T	si_pos;		/* lpos_T of every match start, sorted */
+    linenr_T	si_done;	/* lines up to this one were searched */
+    linenr_T	si_dirty_top;	/* first line to search again, zero when
+				   there is none */
+    linenr_T	si_dirty_bot;	/* line below the last one to search again */
+} searchidx_T;
+#endif
+
 struct file_buffer
 {
     memline_T	b_ml;		/* associated memline (also contains line
@@ -1901,6 +1976,9 @@ struct file_buffer
 				   change */
     long	b_mod_xlines;	/* number of extra buffer lines inserted;
 				   negative when lines were deleted */
+#ifdef FEAT_SEARCH_EXTRA
+    searchidx_T	b_sidx;		/* matches of the last search pattern */
+#endif
 
     wininfo_T	*b_wininfo;	/* list of last used info for each window */
 
@@ -1908,6 +1986,11 @@ struct file_buffer
     long	b_mtime_read;	/* last change time when reading */
     off_T	b_orig_size;	/* size of original file in bytes */
     int		b_orig_mode;	/* mode of original file */
+#ifdef FEAT_FILEWATCH
+    int		b_watch_wd;	/* inotify watch descriptor, zero when the
+				 * file is not being watched */
+    int		b_watch_changed; /* an event was received for the file */
+#endif
 #ifdef FEAT_VIMINFO
     time_T	b_last_used;	/* time when the buffer was last used; used
 				 * for viminfo */
@@ -134,6 +134,8 @@ static void hl_do_font(int idx, char_u *arg, int do_normal, int do_menu, int do_
 static char *(spo_name_tab[SPO_COUNT]) =
 	    {"ms=", "me=", "hs=", "he=", "rs=", "re=", "lc="};
 
+#define SP_MUST_LEN	8	/* size of sp_must[] */
+
 /*
  * The patterns that are being searched for are stored in a syn_pattern.
  * A match item consists of one pattern.
@@ -168,6 +170,8 @@ typedef struct syn_pattern
     int		 sp_sync_idx;		/* sync item index (syncing only) */
     int		 sp_line_id;		/* ID of last line where tried */
     int		 sp_startcol;		/* next match in sp_line_id line */
+    char_u	 sp_must[SP_MUST_LEN];	/* bytes every match contains */
+    char	 sp_must_ic;		/* sp_must[] ignores case */
 } synpat_T;
 
 /* The sp_off_flags are computed like this:
@@ -376,6 +380,9 @@ static garray_T current_state		/* current stack of state_items */
 static short	*current_next_list = NULL; /* when non-zero, nextgroup list */
 static int	current_next_flags = 0; /* flags for current_next_list */
 static int	current_line_id = 0;	/* unique number for current line */
+static char_u	syn_line_bytes[32];	/* bytes in the line, bit per byte */
+static int	syn_line_bytes_id = 0;	/* current_line_id for syn_line_bytes */
+static linenr_T	syn_line_bytes_lnum = 0; /* line number for syn_line_bytes */
 
 #define CUR_STATE(idx)	((stateitem_T *)(current_state.ga_data))[idx]
 
@@ -433,6 +440,7 @@ static void syn_add_end_off(lpos_T *result, regmmatch_T *regmatch, synpat_T *spp
 static void syn_add_start_off(lpos_T *result, regmmatch_T *regmatch, synpat_T *spp, int idx, int extra);
 static char_u *syn_getcurline(void);
 static int syn_regexec(regmmatch_T *rmp, linenr_T lnum, colnr_T col, syn_time_T *st);
+static int syn_line_has_must(synpat_T *spp, linenr_T lnum);
 static int check_keyword_id(char_u *line, int startcol, int *endcol, long *flags, short **next_list, stateitem_T *cur_si, int *ccharp);
 static void syn_cmd_case(exarg_T *eap, int syncing);
 static void syn_cmd_spell(exarg_T *eap, int syncing);
@@ -453,6 +461,18 @@ static void syn_cmd_list(exarg_T *eap, int syncing);
 static void syn_lines_msg(void);
 static void syn_match_msg(void);
 static void syn_stack_free_block(synblock_T *block);
+#ifdef FEAT_SYN_CACHE
+static char_u *syn_cache_file_name(char_u *ffname);
+static void syn_cache_buf_hash(buf_T *buf, char_u *hash);
+static void syn_cache_hash_str(context_sha256_T *ctx, char_u *s);
+static void syn_cache_hash_nr(context_sha256_T *ctx, long n);
+static void syn_cache_hash_id(context_sha256_T *ctx, synblock_T *block, int id);
+static void syn_cache_hash_list(context_sha256_T *ctx, synblock_T *block, short *list);
+static void syn_cache_hash_syn(context_sha256_T *ctx, synblock_T *block, struct sp_syn *ss);
+static void syn_cache_def_hash(synblock_T *block, buf_T *buf, char_u *hash);
+static int syn_cache_state_ok(synstate_T *p);
+static void syn_cache_read(void);
+#endif
 static void syn_list_one(int id, int syncing, int link_only);
 static void syn_list_cluster(int id);
 static void put_id_list(char_u *name, short *list, int attr);
@@ -532,6 +552,20 @@ syntax_start(win_T *wp, linenr_T lnum)
 	return;		/* out of memory */
     syn_block->b_sst_lasttick = display_tick;
 
+#ifdef FEAT_SYN_CACHE
+    /*
+     * The first time after the syntax items were defined, try using states
+     * saved when the file was edited before.
+     */
+    if (!syn_block->b_sst_cache_tried)
+    {
+	syn_block->b_sst_cache_tried = TRUE;
+	if (*p_scdir != NUL && syn_block == &syn_buf->b_s
+						   && !bufIsChanged(syn_buf))
+	    syn_cache_read();
+    }
+#endif
+
     /*
      * If the state of the end of the previous line is useful, store it.
      */
@@ -667,6 +701,67 @@ syntax_start(win_T *wp, linenr_T lnum)
     syn_start_line();
 }
 
+/*
+ * Parse syntax ahead in the windows of the current tab page, while waiting
+ * for the user to type a character.  The buffer is parsed from the top in
+ * steps of the normal distance between saved states, so that jumping or
+ * scrolling to any line later finds a saved state close by and does not need
+ * to resync.  Stops after about SST_IDLE_MSEC msec.
+ * Returns TRUE when there is more to parse.
+ */
+    int
+syn_parse_idle(void)
+{
+    win_T	*wp;
+    linenr_T	lnum;
+    linenr_T	lcount;
+    linenr_T	dist;
+    int		more = FALSE;
+#ifdef FEAT_RELTIME
+    proftime_T	tm;
+
+    profile_setlimit(SST_IDLE_MSEC, &tm);
+#endif
+    FOR_ALL_WINDOWS(wp)
+    {
+	lcount = wp->w_buffer->b_ml.ml_line_count;
+	if (!syntax_present(wp) || wp->w_s->b_sst_idle_lnum >= lcount)
+	    continue;
+
+	/* Continue from the state saved at the last line parsed. */
+	syntax_start(wp, wp->w_s->b_sst_idle_lnum > 0
+					     ? wp->w_s->b_sst_idle_lnum : 1);
+	if (syn_block->b_sst_array == NULL)
+	    return FALSE;
+	if (syn_block->b_sst_len <= Rows)
+	    dist = lcount;
+	else
+	    dist = lcount / (syn_block->b_sst_len - Rows) + 1;
+
+	while (syn_block->b_sst_idle_lnum < lcount)
+	{
+	    lnum = syn_block->b_sst_idle_lnum + dist;
+	    if (lnum > lcount)
+		lnum = lcount;
+	    syntax_start(wp, lnum);
+	    if (got_int)
+		return FALSE;
+	    syn_block->b_sst_idle_lnum = lnum;
+#ifdef FEAT_RELTIME
+	    if (profile_passed_limit(&tm))
+#endif
+		break;
+	}
+	if (syn_block->b_sst_idle_lnum < lcount)
+	    more = TRUE;
+#ifdef FEAT_RELTIME
+	if (profile_passed_limit(&tm))
+#endif
+	    break;
+    }
+    return more;
+}
+
 /*
  * We cannot simply discard growarrays full of state_items or buf_states; we
  * have to manually release their extmatch pointers first.
@@ -1174,6 +1269,7 @@ syn_stack_free_block(synblock_T *block)
 	block->b_sst_array = NULL;
 	block->b_sst_len = 0;
     }
+    block->b_sst_idle_lnum = 0;
 }
 /*
  * Free b_sst_array[] for buffer "buf".
@@ -1302,6 +1398,10 @@ syn_stack_apply_changes_block(synblock_T *block, buf_T *buf)
     synstate_T	*p, *prev, *np;
     linenr_T	n;
 
+    /* Parsing ahead must start again above the change. */
+    if (block->b_sst_idle_lnum >= buf->b_mod_top)
+	block->b_sst_idle_lnum = buf->b_mod_top - 1;
+
     if (block->b_sst_array == NULL)	/* nothing to do */
 	return;
 
@@ -1611,6 +1711,492 @@ load_current_state(synstate_T *from)
     current_lnum = from->sst_lnum;
 }
 
+#if defined(FEAT_SYN_CACHE) || defined(PROTO)
+
+# define SC_START_MAGIC	    "Vim\237SynC\345"	/* magic at start of file */
+# define SC_START_MAGIC_LEN 9
+# define SC_END_MAGIC	    0x3e8		/* magic after the states */
+# define SC_VERSION	    1			/* 2-byte file format version */
+# define SC_HASH_SIZE	    32			/* size of a sha256 hash */
+# define SC_STATE_NRS	    3			/* numbers for each state */
+# define SC_ITEM_NRS	    4			/* numbers for each stack item */
+
+/*
+ * Return an allocated string with the name of the file in 'syncachedir' that
+ * holds the syntax states for file "ffname".  The name is the full path of
+ * the file with path separators replaced with '%', like for 'undodir'.
+ * Returns NULL when 'syncachedir' is not an existing directory.
+ */
+    static char_u *
+syn_cache_file_name(char_u *ffname)
+{
+    char_u	*munged_name;
+    char_u	*cache_name;
+    char_u	*p;
+
+    if (ffname == NULL || *p_scdir == NUL || !mch_isdir(p_scdir))
+	return NULL;
+    munged_name = vim_strsave(ffname);
+    if (munged_name == NULL)
+	return NULL;
+    for (p = munged_name; *p != NUL; mb_ptr_adv(p))
+	if (vim_ispathsep(*p))
+	    *p = '%';
+    cache_name = concat_fnames(p_scdir, munged_name, TRUE);
+    vim_free(munged_name);
+    return cache_name;
+}
+
+/*
+ * Compute the hash of the text of buffer "buf" into hash[SC_HASH_SIZE].
+ */
+    static void
+syn_cache_buf_hash(buf_T *buf, char_u *hash)
+{
+    context_sha256_T	ctx;
+    linenr_T		lnum;
+    char_u		*p;
+
+    sha256_start(&ctx);
+    for (lnum = 1; lnum <= buf->b_ml.ml_line_count; ++lnum)
+    {
+	p = ml_get_buf(buf, lnum, FALSE);
+	sha256_update(&ctx, p, (UINT32_T)(STRLEN(p) + 1));
+    }
+    sha256_finish(&ctx, hash);
+}
+
+    static void
+syn_cache_hash_str(context_sha256_T *ctx, char_u *s)
+{
+    if (s == NULL)
+	s = (char_u *)"";
+    sha256_update(ctx, s, (UINT32_T)(STRLEN(s) + 1));
+}
+
+    static void
+syn_cache_hash_nr(context_sha256_T *ctx, long n)
+{
+    char_u	buf[NUMBUFLEN];
+
+    vim_snprintf((char *)buf, NUMBUFLEN, "%ld", n);
+    syn_cache_hash_str(ctx, buf);
+}
+
+/*
+ * Add a group or cluster ID to the hash.  Use the name, the number of a
+ * highlight group is different when the groups are defined in another order.
+ */
+    static void
+syn_cache_hash_id(context_sha256_T *ctx, synblock_T *block, int id)
+{
+    if (id > 0 && id <= highlight_ga.ga_len)
+	syn_cache_hash_str(ctx, HL_TABLE()[id - 1].sg_name);
+    else if (id >= SYNID_CLUSTER
+			&& id - SYNID_CLUSTER < block->b_syn_clusters.ga_len)
+    {
+	syn_cache_hash_str(ctx, (char_u *)"@");
+	syn_cache_hash_str(ctx, SYN_CLSTR(block)[id - SYNID_CLUSTER].scl_name);
+    }
+    else
+	syn_cache_hash_nr(ctx, (long)id);
+}
+
+    static void
+syn_cache_hash_list(context_sha256_T *ctx, synblock_T *block, short *list)
+{
+    if (list == ID_LIST_ALL)
+	syn_cache_hash_str(ctx, (char_u *)"ALL");
+    else if (list != NULL)
+	for ( ; *list != 0; ++list)
+	    syn_cache_hash_id(ctx, block, *list);
+    syn_cache_hash_str(ctx, (char_u *)"");
+}
+
+    static void
+syn_cache_hash_syn(context_sha256_T *ctx, synblock_T *block, struct sp_syn *ss)
+{
+    syn_cache_hash_nr(ctx, (long)ss->inc_tag);
+    syn_cache_hash_id(ctx, block, ss->id);
+    syn_cache_hash_list(ctx, block, ss->cont_in_list);
+}
+
+/*
+ * Compute a hash of everything that the syntax states of "block" in buffer
+ * "buf" depend on into hash[SC_HASH_SIZE].  Saved states can only be used
+ * when the syntax items are defined in exactly the same way.
+ */
+    static void
+syn_cache_def_hash(synblock_T *block, buf_T *buf, char_u *hash)
+{
+    context_sha256_T	ctx;
+    synpat_T		*spp;
+    hashtab_T		*ht;
+    hashitem_T		*hi;
+    keyentry_T		*kp;
+    int			todo;
+    int			i;
+    int			j;
+
+    sha256_start(&ctx);
+    syn_cache_hash_str(&ctx, p_enc);
+    syn_cache_hash_nr(&ctx, buf->b_p_smc);
+    syn_cache_hash_str(&ctx, block->b_syn_isk != empty_option
+					     ? block->b_syn_isk : buf->b_p_isk);
+    syn_cache_hash_nr(&ctx, (long)block->b_syn_ic);
+    syn_cache_hash_nr(&ctx, (long)block->b_syn_containedin);
+    syn_cache_hash_nr(&ctx, (long)block->b_syn_sync_flags);
+    syn_cache_hash_id(&ctx, block, block->b_syn_sync_id);
+    syn_cache_hash_nr(&ctx, block->b_syn_sync_minlines);
+    syn_cache_hash_nr(&ctx, block->b_syn_sync_maxlines);
+    syn_cache_hash_nr(&ctx, block->b_syn_sync_linebreaks);
+    syn_cache_hash_str(&ctx, block->b_syn_linecont_pat);
+    syn_cache_hash_nr(&ctx, (long)block->b_syn_linecont_ic);
+
+    for (i = 0; i < block->b_syn_patterns.ga_len; ++i)
+    {
+	spp = &(SYN_ITEMS(block)[i]);
+	syn_cache_hash_nr(&ctx, (long)spp->sp_type);
+	syn_cache_hash_nr(&ctx, (long)spp->sp_syncing);
+	syn_cache_hash_nr(&ctx, (long)spp->sp_flags);
+#ifdef FEAT_CONCEAL
+	syn_cache_hash_nr(&ctx, (long)spp->sp_cchar);
+#endif
+	syn_cache_hash_syn(&ctx, block, &spp->sp_syn);
+	syn_cache_hash_id(&ctx, block, spp->sp_syn_match_id);
+	syn_cache_hash_str(&ctx, spp->sp_pattern);
+	syn_cache_hash_nr(&ctx, (long)spp->sp_ic);
+	syn_cache_hash_nr(&ctx, (long)spp->sp_off_flags);
+	for (j = 0; j < SPO_COUNT; ++j)
+	    syn_cache_hash_nr(&ctx, (long)spp->sp_offsets[j]);
+	syn_cache_hash_list(&ctx, block, spp->sp_cont_list);
+	syn_cache_hash_list(&ctx, block, spp->sp_next_list);
+	syn_cache_hash_nr(&ctx, (long)spp->sp_sync_idx);
+    }
+
+    for (i = 0; i < block->b_syn_clusters.ga_len; ++i)
+    {
+	syn_cache_hash_str(&ctx, SYN_CLSTR(block)[i].scl_name);
+	syn_cache_hash_list(&ctx, block, SYN_CLSTR(block)[i].scl_list);
+    }
+
+    for (ht = &block->b_keywtab; ht != NULL;
+		       ht = ht == &block->b_keywtab ? &block->b_keywtab_ic : NULL)
+    {
+	todo = (int)ht->ht_used;
+	for (hi = ht->ht_array; todo > 0; ++hi)
+	    if (!HASHITEM_EMPTY(hi))
+	    {
+		--todo;
+		for (kp = HI2KE(hi); kp != NULL; kp = kp->ke_next)
+		{
+		    syn_cache_hash_str(&ctx, kp->keyword);
+		    syn_cache_hash_syn(&ctx, block, &kp->k_syn);
+		    syn_cache_hash_list(&ctx, block, kp->next_list);
+		    syn_cache_hash_nr(&ctx, (long)kp->flags);
+		    syn_cache_hash_nr(&ctx, (long)kp->k_char);
+		}
+	    }
+	syn_cache_hash_str(&ctx, (char_u *)"");
+    }
+    sha256_finish(&ctx, hash);
+}
+
+/*
+ * Return TRUE when saved state "p" can be written to the cache file: it must
+ * be valid and not refer to other memory.
+ */
+    static int
+syn_cache_state_ok(synstate_T *p)
+{
+    bufstate_T	*bp;
+    int		i;
+
+    if (p->sst_change_lnum != 0 || p->sst_next_list != NULL)
+	return FALSE;
+    if (p->sst_stacksize > SST_FIX_STATES)
+	bp = SYN_STATE_P(&(p->sst_union.sst_ga));
+    else
+	bp = p->sst_union.sst_stack;
+    for (i = 0; i < p->sst_stacksize; ++i)
+	if (bp[i].bs_extmatch != NULL)
+	    return FALSE;
+    return TRUE;
+}
+
+/*
+ * Write the saved syntax states of buffer "buf" to a file in 'syncachedir',
+ * so that they can be used when the same file is edited again.  Nothing is
+ * written when the buffer was changed, the states are for the text that is
+ * not in the file.
+ */
+    void
+syn_cache_write(buf_T *buf)
+{
+    synblock_T	*block = &buf->b_s;
+    synstate_T	*p;
+    bufstate_T	*bp;
+    char_u	*file_name;
+    int		fd;
+    FILE	*fp;
+    int		perm;
+#ifdef UNIX
+    stat_T	st_old;
+    stat_T	st_new;
+    int		st_old_valid = FALSE;
+#endif
+    char_u	hash[SC_HASH_SIZE];
+    long	count = 0;
+    int		write_ok;
+    int		i;
+
+    if (*p_scdir == NUL || buf->b_ml.ml_mfp == NULL || bufIsChanged(buf)
+	    || block->b_sst_array == NULL)
+	return;
+    for (p = block->b_sst_first; p != NULL; p = p->sst_next)
+	if (syn_cache_state_ok(p))
+	    ++count;
+    if (count == 0)
+	return;
+
+    file_name = syn_cache_file_name(buf->b_ffname);
+    if (file_name == NULL)
+	return;
+
+    /* Use the permission of the original file, the cache file contains a
+     * hash of its text. */
+#ifdef UNIX
+    perm = 0600;
+    if (mch_stat((char *)buf->b_ffname, &st_old) >= 0)
+    {
+	perm = st_old.st_mode;
+	st_old_valid = TRUE;
+    }
+#else
+    perm = mch_getperm(buf->b_ffname);
+    if (perm < 0)
+	perm = 0600;
+#endif
+    /* strip any s-bit and executable bit */
+    perm = perm & 0666;
+
+    /* If the cache file already exists, verify that it actually is a syntax
+     * cache file, and delete it. */
+    if (mch_getperm(file_name) >= 0)
+    {
+	char_u	mbuf[SC_START_MAGIC_LEN];
+	int	len = 0;
+
+	fd = mch_open((char *)file_name, O_RDONLY|O_EXTRA, 0);
+	if (fd >= 0)
+	{
+	    len = read_eintr(fd, mbuf, SC_START_MAGIC_LEN);
+	    close(fd);
+	}
+	if (len < SC_START_MAGIC_LEN
+		|| memcmp(mbuf, SC_START_MAGIC, SC_START_MAGIC_LEN) != 0)
+	    goto theend;
+	mch_remove(file_name);
+    }
+
+    fd = mch_open((char *)file_name,
+			    O_CREAT|O_EXTRA|O_WRONLY|O_EXCL|O_NOFOLLOW, perm);
+    if (fd < 0)
+	goto theend;
+    (void)mch_setperm(file_name, perm);
+#ifdef UNIX
+    /* Try to set the group of the cache file same as the original file.  If
+     * this fails, set the protection bits for the group same as the
+     * protection bits for others. */
+    if (st_old_valid
+	    && mch_stat((char *)file_name, &st_new) >= 0
+	    && st_new.st_gid != st_old.st_gid
+# ifdef HAVE_FCHOWN  /* sequent-ptx lacks fchown() */
+	    && fchown(fd, (uid_t)-1, st_old.st_gid) != 0
+# endif
+       )
+	mch_setperm(file_name, (perm & 0707) | ((perm & 07) << 3));
+#endif
+    fp = fdopen(fd, "w");
+    if (fp == NULL)
+    {
+	close(fd);
+	mch_remove(file_name);
+	goto theend;
+    }
+
+    write_ok = fwrite(SC_START_MAGIC, (size_t)SC_START_MAGIC_LEN,
+							  (size_t)1, fp) == 1
+	&& put_bytes(fp, (long_u)SC_VERSION, 2) == OK
+	&& put_bytes(fp, (long_u)buf->b_ml.ml_line_count, 4) == OK;
+    syn_cache_buf_hash(buf, hash);
+    if (write_ok)
+	write_ok = fwrite(hash, (size_t)SC_HASH_SIZE, (size_t)1, fp) == 1;
+    syn_cache_def_hash(block, buf, hash);
+    if (write_ok)
+	write_ok = fwrite(hash, (size_t)SC_HASH_SIZE, (size_t)1, fp) == 1
+			    && put_bytes(fp, (long_u)count, 4) == OK;
+
+    for (p = block->b_sst_first; write_ok && p != NULL; p = p->sst_next)
+    {
+	if (!syn_cache_state_ok(p))
+	    continue;
+	write_ok = put_bytes(fp, (long_u)p->sst_lnum, 4) == OK
+		&& put_bytes(fp, (long_u)p->sst_next_flags, 4) == OK
+		&& put_bytes(fp, (long_u)p->sst_stacksize, 4) == OK;
+	if (p->sst_stacksize > SST_FIX_STATES)
+	    bp = SYN_STATE_P(&(p->sst_union.sst_ga));
+	else
+	    bp = p->sst_union.sst_stack;
+	for (i = 0; write_ok && i < p->sst_stacksize; ++i)
+	    write_ok = put_bytes(fp, (long_u)bp[i].bs_idx, 4) == OK
+		    && put_bytes(fp, (long_u)bp[i].bs_flags, 4) == OK
+#ifdef FEAT_CONCEAL
+		    && put_bytes(fp, (long_u)bp[i].bs_seqnr, 4) == OK
+		    && put_bytes(fp, (long_u)bp[i].bs_cchar, 4) == OK;
+#else
+		    && put_bytes(fp, 0L, 4) == OK
+		    && put_bytes(fp, 0L, 4) == OK;
+#endif
+    }
+    if (write_ok)
+	write_ok = put_bytes(fp, (long_u)SC_END_MAGIC, 4) == OK;
+    if (fclose(fp) != 0)
+	write_ok = FALSE;
+    if (!write_ok)
+	mch_remove(file_name);
+
+theend:
+    vim_free(file_name);
+}
+
+/*
+ * Read saved syntax states for syn_buf from 'syncachedir'.  They are only
+ * used when they were written for the same text and the same syntax items.
+ * The numbers are all read and checked before storing any state, a truncated
+ * or damaged file is ignored.
+ */
+    static void
+syn_cache_read(void)
+{
+    char_u	*file_name;
+    FILE	*fp;
+    char_u	magic[SC_START_MAGIC_LEN];
+    char_u	file_hash[SC_HASH_SIZE];
+    char_u	hash[SC_HASH_SIZE];
+    garray_T	ga;
+    int		*nrs;
+    long	count;
+    long	n;
+    int		stacksize;
+    int		idx;
+    int		i;
+    stateitem_T	*sip;
+    int		ok = FALSE;
+
+    file_name = syn_cache_file_name(syn_buf->b_ffname);
+    if (file_name == NULL)
+	return;
+    fp = mch_fopen((char *)file_name, READBIN);
+    vim_free(file_name);
+    if (fp == NULL)
+	return;
+    ga_init2(&ga, (int)sizeof(int), 1000);
+
+    if (fread(magic, (size_t)SC_START_MAGIC_LEN, (size_t)1, fp) != 1
+	    || memcmp(magic, SC_START_MAGIC, SC_START_MAGIC_LEN) != 0
+	    || get2c(fp) != SC_VERSION
+	    || get4c(fp) != syn_buf->b_ml.ml_line_count)
+	goto theend;
+    if (fread(file_hash, (size_t)SC_HASH_SIZE, (size_t)1, fp) != 1)
+	goto theend;
+    syn_cache_buf_hash(syn_buf, hash);
+    if (memcmp(file_hash, hash, SC_HASH_SIZE) != 0)
+	goto theend;
+    if (fread(file_hash, (size_t)SC_HASH_SIZE, (size_t)1, fp) != 1)
+	goto theend;
+    syn_cache_def_hash(syn_block, syn_buf, hash);
+    if (memcmp(file_hash, hash, SC_HASH_SIZE) != 0)
+	goto theend;
+
+    /* Read all the numbers, checking the line numbers and pattern indexes,
+     * so that a bad file can't cause trouble. */
+    count = get4c(fp);
+    if (count <= 0 || count > SST_MAX_ENTRIES * 10)
+	goto theend;
+    for (n = 0; n < count; ++n)
+    {
+	if (ga_grow(&ga, SC_STATE_NRS) == FAIL)
+	    goto theend;
+	nrs = (int *)ga.ga_data + ga.ga_len;
+	for (i = 0; i < SC_STATE_NRS; ++i)
+	    nrs[i] = get4c(fp);
+	ga.ga_len += SC_STATE_NRS;
+	stacksize = nrs[2];
+	if (nrs[0] < 1 || nrs[0] > syn_buf->b_ml.ml_line_count
+					 || stacksize < 0 || stacksize > 1000)
+	    goto theend;
+	if (ga_grow(&ga, stacksize * SC_ITEM_NRS) == FAIL)
+	    goto theend;
+	nrs = (int *)ga.ga_data + ga.ga_len;
+	for (i = 0; i < stacksize * SC_ITEM_NRS; ++i)
+	    nrs[i] = get4c(fp);
+	ga.ga_len += stacksize * SC_ITEM_NRS;
+	for (i = 0; i < stacksize; ++i)
+	{
+	    idx = nrs[i * SC_ITEM_NRS];
+	    if (idx < KEYWORD_IDX || idx >= syn_block->b_syn_patterns.ga_len)
+		goto theend;
+	}
+    }
+    if (get4c(fp) != SC_END_MAGIC || feof(fp))
+	goto theend;
+    ok = TRUE;
+
+theend:
+    fclose(fp);
+    if (!ok)
+    {
+	ga_clear(&ga);
+	return;
+    }
+
+    /* Store the states, going through current_state like when parsing. */
+    nrs = (int *)ga.ga_data;
+    for (n = 0; n < count; ++n)
+    {
+	clear_current_state();
+	validate_current_state();
+	stacksize = nrs[2];
+	if (stacksize > 0 && ga_grow(&current_state, stacksize) == FAIL)
+	    break;
+	for (i = 0; i < stacksize; ++i)
+	{
+	    sip = &CUR_STATE(i);
+	    vim_memset(sip, 0, sizeof(stateitem_T));
+	    sip->si_idx = nrs[SC_STATE_NRS + i * SC_ITEM_NRS];
+	    sip->si_flags = nrs[SC_STATE_NRS + i * SC_ITEM_NRS + 1];
+#ifdef FEAT_CONCEAL
+	    sip->si_seqnr = nrs[SC_STATE_NRS + i * SC_ITEM_NRS + 2];
+	    sip->si_cchar = nrs[SC_STATE_NRS + i * SC_ITEM_NRS + 3];
+#endif
+	}
+	current_state.ga_len = stacksize;
+	current_next_list = NULL;
+	current_next_flags = nrs[1];
+	current_lnum = nrs[0];
+	(void)store_current_state();
+
+	/* No need to parse ahead up to here. */
+	if (current_lnum > syn_block->b_sst_idle_lnum)
+	    syn_block->b_sst_idle_lnum = current_lnum;
+	nrs += SC_STATE_NRS + stacksize * SC_ITEM_NRS;
+    }
+    invalidate_current_state();
+    ga_clear(&ga);
+}
+#endif
+
 /*
  * Compare saved state stack "*sp" with the current state.
  * Return TRUE when they are equal.
@@ -2107,6 +2693,13 @@ syn_current_attr(
 				continue;
 			    spp->sp_line_id = current_line_id;
 
+			    if (!syn_line_has_must(spp, current_lnum))
+			    {
+				/* a byte every match contains is missing */
+				spp->sp_startcol = MAXCOL;
+				continue;
+			    }
+
 			    lc_col = current_col - spp->sp_offsets[SPO_LC_OFF];
 			    if (lc_col < 0)
 				lc_col = 0;
@@ -2995,6 +3588,8 @@ find_endpos(
 	    spp = &(SYN_ITEMS(syn_block)[idx]);
 	    if (spp->sp_type != SPTYPE_END)	/* past last END pattern */
 		break;
+	    if (!syn_line_has_must(spp, startpos->lnum))
+		continue;
 	    lc_col -= spp->sp_offsets[SPO_LC_OFF];
 	    if (lc_col < 0)
 		lc_col = 0;
@@ -3027,7 +3622,7 @@ find_endpos(
 	 * If the skip pattern matches before the end pattern,
 	 * continue searching after the skip pattern.
 	 */
-	if (spp_skip != NULL)
+	if (spp_skip != NULL && syn_line_has_must(spp_skip, startpos->lnum))
 	{
 	    int lc_col = matchcol - spp_skip->sp_offsets[SPO_LC_OFF];
 	    int r;
@@ -3328,6 +3923,44 @@ syn_regexec(
     return FALSE;
 }
 
+/*
+ * Return FALSE when line "lnum" does not contain all the bytes that every
+ * match of pattern "spp" contains, thus it can't match in this line.
+ */
+    static int
+syn_line_has_must(synpat_T *spp, linenr_T lnum)
+{
+    char_u	*p;
+    int		c;
+
+    if (spp->sp_must[0] == NUL)
+	return TRUE;
+
+    /* Find out what bytes the line contains, once per line. */
+    if (syn_line_bytes_id != current_line_id || syn_line_bytes_lnum != lnum)
+    {
+	vim_memset(syn_line_bytes, 0, sizeof(syn_line_bytes));
+	for (p = ml_get_buf(syn_buf, lnum, FALSE); *p != NUL; ++p)
+	    syn_line_bytes[*p >> 3] |= 1 << (*p & 7);
+	syn_line_bytes_id = current_line_id;
+	syn_line_bytes_lnum = lnum;
+    }
+
+    for (p = spp->sp_must; *p != NUL; ++p)
+    {
+	if (syn_line_bytes[*p >> 3] & (1 << (*p & 7)))
+	    continue;
+	if (!spp->sp_must_ic)
+	    return FALSE;
+	c = TOLOWER_ASC(*p);
+	if (c == *p)
+	    c = TOUPPER_ASC(*p);
+	if (!(syn_line_bytes[c >> 3] & (1 << (c & 7))))
+	    return FALSE;
+    }
+    return TRUE;
+}
+
 /*
  * Check one position in a line for a matching keyword.
  * The caller must check if a keyword can start at startcol.
@@ -3348,32 +3981,75 @@ check_keyword_id(
     int		round;
     int		kwlen;
     char_u	keyword[MAXKEYWLEN + 1]; /* assume max. keyword len is 80 */
+    char_u	keyword_ic[MAXKEYWLEN + 1];
     hashtab_T	*ht;
     hashitem_T	*hi;
+    hash_T	hash = 0;
+    hash_T	hash_ic = 0;
+    int		fold_ok;
+    int		c;
+    int		fc;
+#ifdef FEAT_MBYTE
+    int		len;
+#endif
 
-    /* Find first character after the keyword.  First character was already
-     * checked. */
+    /* Quickly skip a word that doesn't start like any keyword. */
     kwp = line + startcol;
+    if (!(syn_block->b_keyw_first[*kwp >> 3] & (1 << (*kwp & 7))))
+	return 0;
+
+    /*
+     * Find first character after the keyword.  First character was already
+     * checked.  Stop when it's too long to be a keyword.
+     * Must make a copy of the keyword, so we can add a NUL.  Make a folded
+     * copy at the same time, and compute the hashes like hash_hash().  This
+     * only works for single-byte characters in b_keyw_fold[], for others
+     * str_foldcase() is used below.
+     */
     kwlen = 0;
-    do
+    fold_ok = syn_block->b_keywtab_ic.ht_used > 0;
+    for (;;)
     {
+	c = kwp[kwlen];
 #ifdef FEAT_MBYTE
-	if (has_mbyte)
-	    kwlen += (*mb_ptr2len)(kwp + kwlen);
+	if (has_mbyte && c >= 0x80)
+	{
+	    if (kwlen > 0 && !vim_iswordp_buf(kwp + kwlen, syn_buf))
+		break;
+	    len = (*mb_ptr2len)(kwp + kwlen);
+	    if (kwlen + len > syn_block->b_keyw_maxlen)
+		return 0;
+	    for ( ; len > 0; --len)
+	    {
+		c = kwp[kwlen];
+		hash = kwlen == 0 ? (hash_T)c : hash * 101 + c;
+		keyword[kwlen++] = c;
+	    }
+	    fold_ok = FALSE;
+	}
 	else
 #endif
-	    ++kwlen;
+	{
+	    /* b_chartab[] is set for the syntax 'iskeyword' */
+	    if (kwlen > 0 && !(syn_buf->b_chartab[c >> 3] & (1 << (c & 7))))
+		break;
+	    if (kwlen >= syn_block->b_keyw_maxlen)
+		return 0;
+	    hash = kwlen == 0 ? (hash_T)c : hash * 101 + c;
+	    if (fold_ok)
+	    {
+		fc = syn_block->b_keyw_fold[c];
+		if (fc == NUL)
+		    fold_ok = FALSE;
+		hash_ic = kwlen == 0 ? (hash_T)fc : hash_ic * 101 + fc;
+		keyword_ic[kwlen] = fc;
+	    }
+	    keyword[kwlen++] = c;
+	}
     }
-    while (vim_iswordp_buf(kwp + kwlen, syn_buf));
-
-    if (kwlen > MAXKEYWLEN)
-	return 0;
-
-    /*
-     * Must make a copy of the keyword, so we can add a NUL and make it
-     * lowercase.
-     */
-    vim_strncpy(keyword, kwp, kwlen);
+    keyword[kwlen] = NUL;
+    if (fold_ok)
+	keyword_ic[kwlen] = NUL;
 
     /*
      * Try twice:
@@ -3385,8 +4061,6 @@ check_keyword_id(
 	ht = round == 1 ? &syn_block->b_keywtab : &syn_block->b_keywtab_ic;
 	if (ht->ht_used == 0)
 	    continue;
-	if (round == 2)	/* ignore case */
-	    (void)str_foldcase(kwp, kwlen, keyword, MAXKEYWLEN + 1);
 
 	/*
 	 * Find keywords that match.  There can be several with different
@@ -3395,7 +4069,13 @@ check_keyword_id(
 	 *  Accept a not-contained keyword at toplevel.
 	 *  Accept a keyword at other levels only if it is in the contains list.
 	 */
-	hi = hash_find(ht, keyword);
+	if (round == 1)
+	    hi = hash_lookup(ht, keyword, hash);
+	else if (fold_ok)
+	    hi = hash_lookup(ht, keyword_ic, hash_ic);
+	else
+	    hi = hash_find(ht, str_foldcase(kwp, kwlen, keyword_ic,
+							     MAXKEYWLEN + 1));
 	if (!HASHITEM_EMPTY(hi))
 	    for (kp = HI2KE(hi); kp != NULL; kp = kp->ke_next)
 	    {
@@ -3560,6 +4240,9 @@ syntax_clear(synblock_T *block)
     /* free the keywords */
     clear_keywtab(&block->b_keywtab);
     clear_keywtab(&block->b_keywtab_ic);
+    vim_memset(block->b_keyw_first, 0, sizeof(block->b_keyw_first));
+    vim_memset(block->b_keyw_first_ic, 0, sizeof(block->b_keyw_first_ic));
+    block->b_keyw_maxlen = 0;
 
     /* free the syntax patterns */
     for (i = block->b_syn_patterns.ga_len; --i >= 0; )
@@ -3590,6 +4273,9 @@ syntax_clear(synblock_T *block)
     /* free the stored states */
     syn_stack_free_all(block);
     invalidate_current_state();
+#ifdef FEAT_SYN_CACHE
+    block->b_sst_cache_tried = FALSE;
+#endif
 
     /* Reset the counter for ":syn include" */
     running_syn_inc_tag = 0;
@@ -4467,6 +5153,11 @@ add_keyword(
     char_u	*name_ic;
     long_u	hash;
     char_u	name_folded[MAXKEYWLEN + 1];
+    synblock_T	*block = curwin->w_s;
+    int		len;
+    int		c;
+    char_u	byte[2];
+    char_u	byte_folded[MB_MAXBYTES + 1];
 
     if (curwin->w_s->b_syn_ic)
 	name_ic = str_foldcase(name, (int)STRLEN(name),
@@ -4505,6 +5196,49 @@ add_keyword(
 	kp->ke_next = HI2KE(hi);
 	hi->hi_key = KE2HIKEY(kp);
     }
+
+    /*
+     * Remember which bytes a keyword can start with and how long it can be,
+     * check_keyword_id() uses this to quickly skip other words.
+     * When ignoring case, any byte that folds to the first byte of the
+     * keyword can start it.  With multi-byte characters other characters
+     * may fold to it and the length may change, allow any non-ASCII byte.
+     */
+    c = kp->keyword[0];
+    len = (int)STRLEN(kp->keyword);
+    if (!block->b_syn_ic)
+	block->b_keyw_first[c >> 3] |= 1 << (c & 7);
+    else
+    {
+	if (!(block->b_keyw_first_ic[c >> 3] & (1 << (c & 7))))
+	{
+	    block->b_keyw_first_ic[c >> 3] |= 1 << (c & 7);
+	    byte[1] = NUL;
+	    for (byte[0] = 255; byte[0] > 0; --byte[0])
+	    {
+		/* Remember how a single-byte character folds, when it folds
+		 * into a single byte. */
+		(void)str_foldcase(byte, 1, byte_folded, MB_MAXBYTES + 1);
+#ifdef FEAT_MBYTE
+		if (has_mbyte && byte[0] >= 0x80)
+		    byte_folded[1] = 'x';
+#endif
+		block->b_keyw_fold[byte[0]] =
+				      byte_folded[1] == NUL ? byte_folded[0] : NUL;
+		if (block->b_keyw_fold[byte[0]] == NUL
+					  || block->b_keyw_fold[byte[0]] == c)
+		    block->b_keyw_first[byte[0] >> 3] |= 1 << (byte[0] & 7);
+	    }
+	}
+#ifdef FEAT_MBYTE
+	if (has_mbyte)
+	    len = MAXKEYWLEN;
+#endif
+    }
+    if (len > MAXKEYWLEN)
+	len = MAXKEYWLEN;
+    if (len > block->b_keyw_maxlen)
+	block->b_keyw_maxlen = len;
 }
 
 /*
@@ -5697,6 +6431,21 @@ get_syn_pattern(char_u *arg, synpat_T *ci)
     if (ci->sp_prog == NULL)
 	return NULL;
     ci->sp_ic = curwin->w_s->b_syn_ic;
+
+    /* Remember bytes that every match contains, to be able to skip a line
+     * without trying the pattern.  Only for a pattern that matches within
+     * one line. */
+    ci->sp_must[0] = NUL;
+    if (re_maxlines(ci->sp_prog) == 0)
+    {
+	int	must_ic;
+
+	if (vim_regmust_text(ci->sp_prog, ci->sp_ic, ci->sp_must,
+						     SP_MUST_LEN, &must_ic) > 0)
+	    ci->sp_must_ic = must_ic;
+	else
+	    ci->sp_must[0] = NUL;
+    }
 #ifdef FEAT_PROFILE
     syn_clear_time(&ci->sp_time);
 #endif
@@ -2399,13 +2399,25 @@ static int		out_pos = 0;	/* number of chars in out_buf */
 out_flush(void)
 {
     int	    len;
+#ifdef FEAT_PROFILE
+    proftime_T	prof_tm;
+#endif
 
     if (out_pos != 0)
     {
 	/* set out_pos to 0 before ui_write, to avoid recursiveness */
 	len = out_pos;
 	out_pos = 0;
-	ui_write(out_buf, len);
+#ifdef FEAT_PROFILE
+	if (redraw_prof_active || redraw_prof_flush)
+	{
+	    profile_start(&prof_tm);
+	    ui_write(out_buf, len);
+	    redraw_prof_end(RDP_OUT_FLUSH, &prof_tm);
+	}
+	else
+#endif
+	    ui_write(out_buf, len);
     }
 }
 
@@ -168,12 +168,16 @@ NEW_TESTS = test_arglist.res \
 	    test_man.res \
 	    test_marks.res \
 	    test_matchadd_conceal.res \
+	    test_memstats.res \
 	    test_nested_function.res \
 	    test_netbeans.res \
 	    test_normal.res \
 	    test_packadd.res \
 	    test_perl.res \
+	    test_put.res \
 	    test_quickfix.res \
+	    test_redrawprofile.res \
+	    test_regexpcache.res \
 	    test_ruby.res \
 	    test_search.res \
 	    test_signs.res \
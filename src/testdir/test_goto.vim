@@ -18,3 +18,58 @@ func Test_gee_dee()
   call assert_equal(14, col('.'))
   quit!
 endfunc
+
+func Test_goto_byte_after_edit()
+  " Byte offsets are computed when first needed after reading a file.
+  call writefile(map(range(1, 2000), '"line " . v:val'), 'Xgotofile')
+  edit Xgotofile
+  call assert_equal(1, line2byte(1))
+  call assert_equal(8, line2byte(2))
+  call assert_equal(8884, line2byte(1000))
+  call assert_equal(1000, byte2line(8884))
+  goto 8884
+  call assert_equal(1000, line('.'))
+
+  edit!
+  1,500delete
+  call append(0, repeat(['x'], 100))
+  call assert_equal(1, line2byte(1))
+  call assert_equal(201, line2byte(101))
+  call assert_equal(101, byte2line(201))
+  goto 201
+  call assert_equal(101, line('.'))
+  call assert_equal('line 501', getline('.'))
+
+  bwipe!
+  call delete('Xgotofile')
+endfunc
+
+func s:check_byte_offsets()
+  let offset = 1
+  for lnum in range(1, line('$'))
+    if lnum % 37 == 0
+      call assert_equal(offset, line2byte(lnum))
+      call assert_equal(lnum, byte2line(offset))
+    endif
+    let offset += len(getline(lnum)) + 1
+  endfor
+  call assert_equal(offset, line2byte(line('$') + 1))
+endfunc
+
+func Test_byte_offsets_many_chunks()
+  " Make sure the byte offset bookkeeping stays correct when chunks of lines
+  " are split and joined.
+  new
+  call setline(1, map(range(1, 5000), 'repeat("x", v:val % 17)'))
+  call s:check_byte_offsets()
+  call append(1234, repeat(['inserted'], 1500))
+  call s:check_byte_offsets()
+  3000,4800delete
+  call s:check_byte_offsets()
+  call setline(2000, repeat('y', 300))
+  100,200s/x/XYZ/g
+  call s:check_byte_offsets()
+  1,$-10delete
+  call s:check_byte_offsets()
+  bwipe!
+endfunc
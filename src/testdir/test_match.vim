@@ -213,4 +213,32 @@ func Test_matchaddpos_using_negative_priority()
   set hlsearch&
 endfunc
 
+func Test_matchadd_multiline_redraw()
+  new
+  call setline(1, ['x', 'x', 'a', 'b', 'x'])
+  let id = matchadd('Search', 'a\nb')
+  redraw
+  let search_attr = screenattr(3, 1)
+  call assert_notequal(screenattr(1, 1), search_attr)
+
+  " Changing the line below the match start redraws the line above.
+  call setline(4, 'c')
+  redraw
+  call assert_equal(screenattr(1, 1), screenattr(3, 1))
+  call setline(4, 'b')
+  redraw
+  call assert_equal(search_attr, screenattr(3, 1))
+
+  " A pattern without a limit also works.
+  call matchdelete(id)
+  call matchadd('Search', 'x\_s*a')
+  redraw
+  call assert_equal(search_attr, screenattr(2, 1))
+  call setline(3, 'c')
+  redraw
+  call assert_notequal(search_attr, screenattr(2, 1))
+  call clearmatches()
+  bwipe!
+endfunc
+
 " vim: shiftwidth=2 sts=2 expandtab
@@ -0,0 +1,40 @@
+" Tests for the :memstats command
+
+func Test_memstats()
+  new
+  call setline(1, range(1, 1000))
+  let lines = split(execute('memstats'), "\n")
+  call assert_match('BUF PAGESIZE', lines[0])
+  call assert_match('^\s*' . bufnr('%') . '\s\+\d\+\s', lines[-1])
+
+  memstats clear
+  let fields = split(split(execute('memstats'), "\n")[-1])
+  " HITS and MISSES are zero after clearing
+  call assert_equal(['0', '0'], fields[4:5])
+  call getline(1, '$')
+  let fields = split(split(execute('memstats'), "\n")[-1])
+  call assert_notequal('0', fields[4])
+
+  call assert_fails('memstats foo', 'E475:')
+  bwipe!
+endfunc
+
+func Test_memstats_cached_blocks()
+  new
+  call setline(1, range(1, 20000))
+  memstats clear
+  " Going back to a line in a block found before does not walk the tree.
+  for i in range(10)
+    call getline(1)
+    call getline(19000)
+  endfor
+  let fields = split(split(execute('memstats'), "\n")[-1])
+  call assert_true(fields[9] >= 18)
+  " After deleting lines the tree is walked again.
+  5000,6000d
+  memstats clear
+  call assert_equal('18001', getline(17000))
+  let fields = split(split(execute('memstats'), "\n")[-1])
+  call assert_equal(['1', '0'], fields[8:9])
+  bwipe!
+endfunc
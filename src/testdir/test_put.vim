@@ -0,0 +1,52 @@
+" Tests for putting and appending many lines at once
+
+func Test_put_many_lines()
+  new
+  call setline(1, map(range(1, 3000), '"line " . v:val'))
+  " break undo sequence
+  let &undolevels = &undolevels
+  let lines = map(range(1, 5000), 'repeat("x", v:val % 100) . v:val')
+  call setreg('a', lines, 'l')
+  1500put a
+  call assert_equal(8000, line('$'))
+  call assert_equal('line 1500', getline(1500))
+  call assert_equal(lines, getline(1501, 6500))
+  call assert_equal('line 1501', getline(6501))
+  call assert_equal([0, 1501, 1, 0], getpos("'["))
+  call assert_equal(6500, line("']"))
+
+  undo
+  call assert_equal(3000, line('$'))
+  call assert_equal('line 1501', getline(1501))
+
+  " with a count
+  normal! 1501G2"ap
+  call assert_equal(13000, line('$'))
+  call assert_equal(lines + lines, getline(1502, 11501))
+  call assert_equal(1 + len(join(getline(1, '$'), "\n")), line2byte(line('$') + 1) - 1)
+  bwipe!
+endfunc
+
+func Test_put_multiline_char()
+  new
+  call setline(1, ['abc', 'def'])
+  call setreg('a', ['one', 'two', 'three', 'four'], 'c')
+  normal! 1G2"ap
+  call assert_equal(['aone', 'two', 'three', 'fourone', 'two', 'three', 'fourbc', 'def'],
+	\ getline(1, '$'))
+  bwipe!
+endfunc
+
+func Test_append_list()
+  new
+  call setline(1, ['first', 'last'])
+  call assert_equal(0, append(1, map(range(1, 2000), '"item " . v:val')))
+  call assert_equal(2002, line('$'))
+  call assert_equal('item 1', getline(2))
+  call assert_equal('item 2000', getline(2001))
+  call assert_equal('last', getline(2002))
+  " numbers in the list
+  call assert_equal(0, append(0, ['a', 1, 'b']))
+  call assert_equal(['a', '1', 'b', 'first'], getline(1, 4))
+  bwipe!
+endfunc
@@ -443,6 +443,47 @@ func Test_vimgreptitle()
   augroup! QfBufWinEnter
 endfunc
 
+func Test_vimgrep_skip_file()
+  call writefile(['one', 'two xyzzy'], 'Xvgr1')
+  call writefile(['three'], 'Xvgr2')
+  call writefile(['XYZZY'], 'Xvgr3')
+  vimgrep /xyzzy/j Xvgr*
+  call assert_equal(['Xvgr1'], map(getqflist(), 'bufname(v:val.bufnr)'))
+  vimgrep /\cxyzzy/j Xvgr*
+  call assert_equal(['Xvgr1', 'Xvgr3'], map(getqflist(), 'bufname(v:val.bufnr)'))
+
+  " I with dot above folds to "i".
+  call writefile(["xyzz\u0130"], 'Xvgr4')
+  vimgrep /\cxyzzi/j Xvgr*
+  call assert_equal(['Xvgr4'], map(getqflist(), 'bufname(v:val.bufnr)'))
+  call delete('Xvgr4')
+
+  " A BufReadCmd autocommand may provide the text.
+  augroup VgrTest
+    au BufReadCmd Xvgr2 call setline(1, 'xyzzy')
+  augroup END
+  vimgrep /xyzzy/j Xvgr*
+  call assert_equal(['Xvgr1', 'Xvgr2'], map(getqflist(), 'bufname(v:val.bufnr)'))
+  augroup VgrTest
+    au!
+  augroup END
+
+  " So may a BufReadPost autocommand.
+  augroup VgrTest
+    au BufReadPost Xvgr2 call setline(1, 'xyzzy')
+  augroup END
+  vimgrep /xyzzy/j Xvgr*
+  call assert_equal(['Xvgr1', 'Xvgr2'], map(getqflist(), 'bufname(v:val.bufnr)'))
+  augroup VgrTest
+    au!
+  augroup END
+  augroup! VgrTest
+
+  call delete('Xvgr1')
+  call delete('Xvgr2')
+  call delete('Xvgr3')
+endfunc
+
 function XqfTitleTests(cchar)
   call s:setup_commands(a:cchar)
 
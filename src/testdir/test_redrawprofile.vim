@@ -0,0 +1,50 @@
+" Tests for the :redrawprofile command
+
+if !has('profile')
+  finish
+endif
+
+func Test_redrawprofile()
+  new
+  call setline(1, range(1, 100))
+  syntax on
+  set ft=vim
+  redrawprofile clear
+  redrawprofile on
+  redraw!
+  normal! 50Gzt
+  redraw
+  redrawprofile off
+  redraw!
+
+  let lines = split(execute('redrawprofile report'), "\n")
+  call assert_match('TOTAL\s\+COUNT', lines[0])
+  call assert_match('^\s*[0-9.]\+\s\+2\s.*redraw$', lines[1])
+  call assert_match('\<win_line\>', join(lines))
+  call assert_match('2 screen updates measured', lines[-1])
+
+  let fname = 'Xredrawprofile.json'
+  exe 'redrawprofile dump ' . fname
+  let d = json_decode(join(readfile(fname)))
+  call assert_equal(2, d.items.redraw.count)
+  call assert_equal(2, len(d.redraws))
+  call assert_true(d.redraws[0].win_line[1] > 0)
+  " the output is flushed after the screen update
+  call assert_true(d.items.out_flush.count > 0)
+  call assert_true(d.redraws[1].out_flush[1] > 0)
+  " the syntax time is added once for every line
+  call assert_equal(d.items.win_line.count, d.items.syntax.count)
+  call assert_equal(len(d.items.syntax.histogram),
+	\ len(d.histogram_usec) + 1)
+  call delete(fname)
+
+  redrawprofile clear
+  let lines = split(execute('redrawprofile report'), "\n")
+  call assert_equal(1, len(lines) - 1)
+  call assert_match('0 screen updates measured', lines[-1])
+
+  call assert_fails('redrawprofile foo', 'E475:')
+  call assert_fails('redrawprofile dump', 'E475:')
+  syntax off
+  bwipe!
+endfunc
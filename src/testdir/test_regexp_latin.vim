@@ -62,3 +62,42 @@ func Test_eow_with_optional()
     call assert_equal(expected, actual)
   endfor
 endfunc
+
+" A literal that must appear in the match is searched for first.
+func Test_must_have_literal()
+  for re in range(0, 2)
+    exe 'set re=' . re
+    call assert_equal(6, match('Quuy  xQuux', '\w\+Quux'))
+    call assert_equal(-1, match('Quuy  xQuu', '\w\+Quux'))
+    call assert_equal(-1, match('Quux', '\w\+Quux'))
+    call assert_equal(2, match('a xquux', '\c\w\+QUUX'))
+    call assert_equal(-1, match('a quux', '\w\+QUUX'))
+    call assert_equal(['a+b=c', 'a'], matchlist('x a+b=c', '\(\w\)+\w=\w')[0:1])
+    call assert_equal(-1, match('x a+b=', '\(\w\)+\w=\w'))
+    call assert_equal(4, match('xyzqxzq', '[xy]*zq\>'))
+    call assert_equal(0, match('xYZQ', '\c[xy]\+zq'))
+  endfor
+  set re=0
+endfunc
+
+" ASCII characters in a collection are checked with a bitmap, one for
+" matching case and one for ignoring case.
+func Test_collection_ignorecase()
+  for re in range(0, 2)
+    exe 'set re=' . re
+    call assert_equal(-1, match('xBy', '[a-c]'))
+    call assert_equal(1, match('xBy', '[a-c]\c'))
+    call assert_equal(0, match('xBy', '[^a-c]'))
+    call assert_equal(2, match('xBy', '[^a-cx]\c'))
+    set ignorecase
+    call assert_equal(1, match('xBy', '[a-c]'))
+    call assert_equal(2, match('xBy', '[^a-cx]'))
+    call assert_equal(1, match('x[?', '[[:punct:]]'))
+    call assert_equal(-1, match('xyz', '[0-9_]'))
+    call assert_equal(0, match("\t", '[\t]'))
+    set noignorecase
+    call assert_equal(-1, match('xBy', '[a-c]'))
+    call assert_equal(1, match('xBy', '[^a-cx]'))
+  endfor
+  set re=0
+endfunc
@@ -92,3 +92,50 @@ func Test_classes_re2()
   call s:classes_test()
   set re=0
 endfunc
+
+" The NFA engine first checks a line with a DFA, the result must be the same
+" as with the backtracking engine.
+func s:search_lines(pats)
+  let res = []
+  for p in a:pats
+    let cnt = []
+    exe 'silent g/' . escape(p, '/') . '/call add(cnt, line(".") . ":" . col("."))'
+    call add(res, p . ' ' . join(cnt, ','))
+    call add(res, p . ' ' . join(map(getline(1, '$'), 'match(v:val, p)'), ','))
+  endfor
+  return res
+endfunc
+
+func Test_nfa_dfa_prefilter()
+  new
+  call setline(1, ['hello world', 'Hello World foo_bar', "\tfoobar  ",
+	\ 'x = 0x1F + 077;', 'word-word', 'café au lait', 'kelvin K', '',
+	\ 'end.'])
+  let pats = ['foo', '^foo', 'bar$', '\<bar\>', '\<\w\+\>$', '^\s*$',
+	\ '[a-z]\+_[a-z]\+', '[^a-z ]\{3}', '0x\x\+', '\u\l', 'hel\|wor',
+	\ '\(foo\|bar\)\{2}', '\k\+-\k\+', 'caf\>', 'ü', 'x\zsy', '\.$',
+	\ '[[:digit:]][[:alpha:]]', '\v<\w{4}>', 'k$']
+  for ic in [0, 1]
+    let &ignorecase = ic
+    for isk in ['@,48-57,_,192-255', '@,48-57,_,192-255,-']
+      let &l:iskeyword = isk
+      set re=1
+      let expected = s:search_lines(pats)
+      set re=2
+      call assert_equal(expected, s:search_lines(pats))
+    endfor
+  endfor
+  set re=0 ignorecase&
+  bwipe!
+endfunc
+
+func Test_nfa_must_char_fold()
+  " The Kelvin sign and I with dot above fold to "k" and "i".
+  set re=2
+  call assert_equal(0, match("aK", '\ca\+k'))
+  call assert_equal(0, match("aİ", '\ca\+i'))
+  call assert_equal(1, match("xfooİbar", '\cfo\+ibar'))
+  set ignorecase
+  call assert_equal(0, match("aİ", 'a\+i'))
+  set re=0 ignorecase&
+endfunc
@@ -0,0 +1,120 @@
+" Tests for the cache of compiled patterns and :regexpcache
+
+func Test_regexpcache()
+  regexpcache clear
+  call assert_equal("\n    HITS  USERS ENGINE LINES PATTERN"
+	\ . "\n0 patterns, 0 found in the cache, 0 compiled",
+	\ execute('regexpcache'))
+
+  for i in range(3)
+    call assert_equal(1, match('abc', 'b\+'))
+  endfor
+  let out = execute('regexpcache')
+  call assert_match("\n       2      0 nfa        0 b\\\\+\n", out)
+  call assert_match("\n1 patterns, 2 found in the cache, 1 compiled$", out)
+
+  " Another engine compiles it again.
+  call assert_equal(1, match('abc', '\%#=1b\+'))
+  call assert_match("\n       0      0 bt         0 \\\\%#=1b\\\\+\n",
+	\ execute('regexpcache'))
+
+  call assert_fails('regexpcache foo', 'E475:')
+  regexpcache clear
+  call assert_match("\n0 patterns, 0 found in the cache, 0 compiled$",
+	\ execute('regexpcache'))
+endfunc
+
+func Test_regexpcache_lines()
+  " The LINES column has the number of line breaks a match can span.
+  new
+  regexpcache clear
+  for pat in ['a\nb', 'a\n\{2,3}', 'x\(\nb\)\@=', 'a\_.*b', '\(\n\)\@<=x']
+    call search(pat, 'nw')
+  endfor
+  let out = execute('regexpcache')
+  call assert_match('\n *0 *0 nfa *1 a\\nb\n', out)
+  call assert_match('\n *0 *0 nfa *3 a\\n\\{2,3}\n', out)
+  call assert_match('\n *0 *0 nfa *1 x\\(\\nb\\)\\@=\n', out)
+  call assert_match('\n *0 *0 nfa *- a\\_\.\*b\n', out)
+  call assert_match('\n *0 *0 nfa *- \\(\\n\\)\\@<=x\n', out)
+
+  " In a string "\n" matches a NL character.
+  call assert_equal(0, match("a\nb", 'a\nb\C'))
+  call assert_match('\n *0 *0 nfa *0 a\\nb\\C\n', execute('regexpcache'))
+  regexpcache clear
+  bwipe!
+endfunc
+
+func Test_regexpcache_options()
+  " 'ignorecase' is used when matching, not when compiling.
+  call assert_equal(-1, match('ABC', 'abc'))
+  set ignorecase
+  call assert_equal(0, match('ABC', 'abc'))
+  set ignorecase&
+
+  " 'cpoptions' changes how the pattern is compiled.
+  new
+  call setline(1, 't')
+  call assert_equal(0, search('[ \t]', 'cnw'))
+  set cpo+=l
+  call assert_equal(1, search('[ \t]', 'cnw'))
+  set cpo-=l
+  call assert_equal(0, search('[ \t]', 'cnw'))
+  bwipe!
+endfunc
+
+func Test_regexpcache_tilde()
+  " "~" uses the previous substitute string, it's not cached.
+  new
+  call setline(1, ['one', 'two'])
+  1s/one/xyz/
+  call assert_equal(1, search('~', 'w'))
+  2s/two/abc/
+  call assert_equal(2, search('~', 'w'))
+  bwipe!
+endfunc
+
+func Test_regexpstats()
+  if !has('profile') || !has('float')
+    return
+  endif
+  set regexpengine=0
+  regexpstats clear
+  call assert_equal(-1, match('abc', 'x\+y'))
+  call assert_match("\n *[0-9.]\\+ \\+1 \\+[0-9.]\\+ \\+- nfa? \\+x\\\\+y\n",
+	\ execute('regexpstats'))
+
+  " A back reference is slow with the NFA engine, the backtracking engine is
+  " tried and is much faster, thus it is used from then on.
+  let text = repeat('foo bar baz qux ', 50) . 'foo'
+  for i in range(41)
+    call assert_equal(-1, match(text, '\(foo\|bar\).*\1x'))
+  endfor
+  call assert_match(" bt  \\+\\\\(foo\\\\|bar\\\\).\\*\\\\1x\n",
+	\ execute('regexpstats'))
+
+  " Measuring stops after the engine was decided.  Which engine is faster
+  " for this pattern depends on the machine.
+  for i in range(41)
+    call assert_equal(8, match(text, 'ba[rz] qux'))
+  endfor
+  let line = matchstr(execute('regexpstats'), '[^\n]*ba\[rz\] qux')
+  call assert_match(' \%(nfa\|bt\) \+ba\[rz\] qux$', line)
+  let measured = str2nr(split(line)[1])
+  call assert_inrange(1, 40, measured)
+  for i in range(10)
+    call assert_equal(8, match(text, 'ba[rz] qux'))
+  endfor
+  let line = matchstr(execute('regexpstats'), '[^\n]*ba\[rz\] qux')
+  call assert_equal(measured, str2nr(split(line)[1]))
+
+  " Not measured when the engine is set.
+  set regexpengine=1
+  call assert_equal(0, match('xy', 'x\+y'))
+  call assert_match("\n *[0-9.]\\+ \\+1 .* x\\\\+y\n", execute('regexpstats'))
+  set regexpengine&
+
+  regexpstats clear
+  call assert_notmatch('x\\+y', execute('regexpstats'))
+  call assert_fails('regexpstats foo', 'E475:')
+endfunc
@@ -279,3 +279,114 @@ func Test_use_sub_pat()
   call X()
   bwipe!
 endfunc
+
+func Test_search_count()
+  new
+  set shortmess-=S
+  call setline(1, ['foo bar', 'xx', 'foo foo', 'yy', 'zz foo'])
+  let &undolevels = &undolevels
+  1
+  let g:a = execute(":unsilent normal! /foo\<CR>")
+  call assert_match('\n/foo *\[2/4\]$', g:a)
+  let g:a = execute(':unsilent normal! n')
+  call assert_match('\[3/4\]$', g:a)
+  let g:a = execute(':unsilent normal! 2n')
+  call assert_match('W \[1/4\]$', g:a)
+  let g:a = execute(':unsilent normal! N')
+  call assert_match('W \[4/4\]$', g:a)
+
+  " The count is updated when the text changes.
+  3delete
+  let g:a = execute(':unsilent normal! gg0n')
+  call assert_match('\[2/2\]$', g:a)
+  let &undolevels = &undolevels
+  call append(0, 'foo foo')
+  let g:a = execute(':unsilent normal! gg0n')
+  call assert_match('\[2/4\]$', g:a)
+  call assert_equal([1, 5], [line('.'), col('.')])
+  let g:a = execute(':unsilent normal! n')
+  call assert_equal([2, 1], [line('.'), col('.')])
+  normal! u
+  let g:a = execute(':unsilent normal! gg0n')
+  call assert_match('\[2/2\]$', g:a)
+  call assert_equal([4, 4], [line('.'), col('.')])
+
+  " Not shown with an offset or a pattern that may match a line break.
+  let g:a = execute(":unsilent normal! gg/foo/e\<CR>")
+  call assert_notmatch('\[', g:a)
+  let g:a = execute(":unsilent normal! gg/foo\\n\<CR>")
+  call assert_notmatch('\[', g:a)
+
+  set shortmess+=S
+  let g:a = execute(":unsilent normal! gg/foo\<CR>")
+  call assert_notmatch('\[', g:a)
+  bwipe!
+endfunc
+
+func Test_search_long_line()
+  new
+  call setline(1, repeat('ab ', 1000) . 'x')
+  normal! $
+  call assert_equal([1, 2998], searchpos('ab', 'b'))
+  call assert_equal([1, 2995], searchpos('ab', 'b'))
+  call assert_equal([1, 2993], searchpos('ab', 'be'))
+  call assert_equal([1, 2995], searchpos('ab', ''))
+  call assert_equal([1, 2996], searchpos('ab', 'e'))
+  " Matches remembered for the line must not be used after a change.
+  s/ab ab x$/AB ab ab x/
+  call cursor(1, 2999)
+  call assert_equal([1, 2998], searchpos('ab', 'b'))
+  call assert_equal([1, 2992], searchpos('ab', 'b'))
+  call assert_equal([1, 2989], searchpos('ab', 'b'))
+  set ignorecase
+  call assert_equal([1, 2992], searchpos('ab', ''))
+  call assert_equal([1, 2995], searchpos('ab', ''))
+  call assert_equal([1, 2992], searchpos('ab', 'b'))
+  set noignorecase
+  bwipe!
+endfunc
+
+func Test_search_empty_line_at_cursor()
+  new
+  call setline(1, ['foobar', '', 'substitute foo asdf', '', 'one two'])
+  " The "c" flag accepts a match at the cursor, also in an empty line.
+  call cursor(2, 1)
+  call assert_equal(2, search('^$', 'c'))
+  call assert_equal(2, search('^$', 'cn'))
+  call assert_equal(2, search('^', 'c'))
+  call assert_equal(2, search('$', 'ce'))
+  call assert_equal(2, search('\d*', 'c'))
+  call assert_equal(4, search('^$'))
+  bwipe!
+endfunc
+
+func Test_ilist_included_files()
+  call writefile(['#include "Xinclude2.h"', 'int one;'], 'Xinclude1.h')
+  call writefile(['#define TWO(x) \', '    (x + 2)', 'int two_count;'],
+	\ 'Xinclude2.h')
+  new
+  call setline(1, ['#include "Xinclude1.h"', 'int main() { two_count; }'])
+  set path=.
+  let a = execute('ilist two_count')
+  call assert_match('Xinclude2.h\n  1:    3 int two_count;\n', a)
+  call assert_match('\n  2:    2 int main', a)
+  call assert_match('  1:    1 #define TWO(x) \\\n  1:    2     (x + 2)',
+	\ execute('dlist TWO'))
+  call assert_match('Xinclude1.h\n  1:    2 int one;', execute('ilist one'))
+
+  " A changed file is read again.
+  call writefile(['#include "Xinclude2.h"', 'int one;', 'int two_count;'],
+	\ 'Xinclude1.h')
+  let a = execute('ilist two_count')
+  call assert_match('Xinclude2.h\n  1:    3 int two_count;\n', a)
+  call assert_match('Xinclude1.h\n  2:    3 int two_count;\n', a)
+
+  " A deleted file is not found.
+  call delete('Xinclude2.h')
+  call assert_match('"Xinclude2.h"  NOT FOUND', execute('checkpath!'))
+  call assert_notmatch('Xinclude2.h', execute('ilist two_count'))
+
+  set path&
+  bwipe!
+  call delete('Xinclude1.h')
+endfunc
@@ -40,6 +40,46 @@ func Test_checktime()
   call assert_equal(fl[0], getline(1))
 endfunc
 
+func Test_checktime_filewatch()
+  if !has('filewatch')
+    return
+  endif
+  let fname = 'Xtest.tmp'
+  let fname2 = 'Xtest2.tmp'
+  call writefile(['one'], fname)
+  set filewatch autoread
+  exe 'e' fname
+  " The first check starts watching the file.
+  checktime
+  call writefile(['one', 'two'], fname)
+  checktime
+  call assert_equal(['one', 'two'], getline(1, '$'))
+
+  " Replacing the file by renaming another one is noticed.
+  call writefile(['one', 'two', 'three'], fname2)
+  call rename(fname2, fname)
+  checktime
+  call assert_equal(['one', 'two', 'three'], getline(1, '$'))
+  call writefile(['four'], fname)
+  checktime
+  call assert_equal(['four'], getline(1, '$'))
+
+  " Deleting and creating the file again is noticed.
+  call delete(fname)
+  call writefile(['five', 'six'], fname)
+  checktime
+  call assert_equal(['five', 'six'], getline(1, '$'))
+
+  set nofilewatch
+  call writefile(['seven'], fname)
+  checktime
+  call assert_equal(['seven'], getline(1, '$'))
+
+  bwipe!
+  set autoread&
+  call delete(fname)
+endfunc
+
 func Test_nonexistent_file()
   let fname='Xtest.tmp'
 
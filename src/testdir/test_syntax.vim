@@ -80,3 +80,199 @@ func Test_syntax_after_reload()
   call assert_true(exists('g:gotit'))
   call delete('Xsomefile')
 endfunc
+
+func s:SynCacheName(lnum)
+  return synIDattr(synID(a:lnum, 1, 1), 'name')
+endfunc
+
+func Test_syntax_cache()
+  if !has('syntax_cache')
+    return
+  endif
+  call mkdir('Xsyncache')
+  set syncachedir=Xsyncache
+  call writefile(['/* start'] + repeat(['inside'], 3000) + ['end */', 'after'],
+	\ 'Xsyncache.c')
+  if has('unix')
+    call setfperm('Xsyncache.c', 'rw-------')
+  endif
+
+  edit Xsyncache.c
+  syn region Comment start=/\/\*/ end=/\*\//
+  syn sync fromstart
+  call assert_equal('Comment', s:SynCacheName(3000))
+  bwipe!
+  let files = glob('Xsyncache/*', 0, 1)
+  call assert_equal(1, len(files))
+  call assert_equal("Vim\x9fSynC", readfile(files[0], 'b')[0][:7])
+  if has('unix')
+    " the cache file gets the permissions of the original file
+    call assert_equal('rw-------', getfperm(files[0]))
+  endif
+
+  " Same syntax items: the saved states are used.
+  edit Xsyncache.c
+  syn region Comment start=/\/\*/ end=/\*\//
+  syn sync fromstart
+  call assert_equal('Comment', s:SynCacheName(3000))
+  call assert_equal('', s:SynCacheName(3003))
+  bwipe!
+
+  " Other syntax items: the saved states are not used.
+  edit Xsyncache.c
+  syn region String start=/\/\*/ end=/\*\//
+  syn sync fromstart
+  call assert_equal('String', s:SynCacheName(3000))
+  bwipe!
+
+  " Changed text: the saved states are not used.
+  call writefile(['start', '/*'] + repeat(['inside'], 3000) + ['*/'],
+	\ 'Xsyncache.c')
+  edit Xsyncache.c
+  syn region String start=/\/\*/ end=/\*\//
+  syn sync fromstart
+  call assert_equal('', s:SynCacheName(1))
+  call assert_equal('String', s:SynCacheName(3000))
+  bwipe!
+
+  " A file that is not a syntax cache file is not overwritten.
+  call writefile(['not a syntax cache'], files[0])
+  edit Xsyncache.c
+  syn region String start=/\/\*/ end=/\*\//
+  syn sync fromstart
+  call assert_equal('String', s:SynCacheName(3000))
+  bwipe!
+  call assert_equal(['not a syntax cache'], readfile(files[0]))
+
+  " A damaged file is ignored.
+  call writefile(["Vim\x9fSynC"], files[0], 'b')
+  edit Xsyncache.c
+  syn region Comment start=/\/\*/ end=/\*\//
+  syn sync fromstart
+  call assert_equal('Comment', s:SynCacheName(3000))
+  bwipe!
+
+  set syncachedir&
+  call delete('Xsyncache', 'rf')
+  call delete('Xsyncache.c')
+endfunc
+
+func Test_syn_keyword_lookup()
+  new
+  call setline(1, ['foo foobar Foo FOO bar BAR Bar baz bazooka xfoo',
+	\ 'verylongkeywordxx verylongkeyword VERYLONGKEYWORDX a ab'])
+  syn keyword Statement foo a
+  syn keyword Statement verylongkeyword
+  syn case ignore
+  syn keyword Type bar ab
+  syn keyword Type verylongkeywordx
+  let expected = ['Statement', '', '', '', 'Type', 'Type', 'Type', '', '', '']
+  let col = 1
+  for word in split(getline(1))
+    call assert_equal(remove(expected, 0),
+	  \ synIDattr(synID(1, col, 1), 'name'), 'word ' . word)
+    let col += len(word) + 1
+  endfor
+  call assert_equal('', synIDattr(synID(2, 1, 1), 'name'))
+  call assert_equal('Statement', synIDattr(synID(2, 19, 1), 'name'))
+  call assert_equal('Type', synIDattr(synID(2, 35, 1), 'name'))
+  call assert_equal('Statement', synIDattr(synID(2, 52, 1), 'name'))
+  call assert_equal('Type', synIDattr(synID(2, 54, 1), 'name'))
+
+  " after clearing the keywords nothing matches
+  syn clear
+  call assert_equal('', synIDattr(synID(1, 1, 1), 'name'))
+  bwipe!
+endfunc
+
+func Test_syn_pattern_must_bytes()
+  new
+  call setline(1, ['one Xyz two', 'begin <<a\>>b>> end', 'abc', 'def', 'x'])
+  syn match Type /xyz/
+  syn match Statement /\cBEGIN/
+  syn match Constant /abc\ndef/
+  syn region String start=/<</ skip=/\\>/ end=/>>/
+  call assert_equal('', synIDattr(synID(1, 5, 1), 'name'))
+  call assert_equal('Statement', synIDattr(synID(2, 1, 1), 'name'))
+  call assert_equal('String', synIDattr(synID(2, 7, 1), 'name'))
+  call assert_equal('String', synIDattr(synID(2, 14, 1), 'name'))
+  call assert_equal('', synIDattr(synID(2, 17, 1), 'name'))
+  call assert_equal('Constant', synIDattr(synID(3, 1, 1), 'name'))
+  call assert_equal('Constant', synIDattr(synID(4, 1, 1), 'name'))
+
+  " with "syn case ignore" both cases can be found in the line
+  syn clear
+  syn case ignore
+  syn match Type /xyz/
+  call assert_equal('Type', synIDattr(synID(1, 5, 1), 'name'))
+
+  " after changing the line the pattern is tried again
+  call assert_equal('', synIDattr(synID(5, 1, 1), 'name'))
+  call setline(5, 'x xyz')
+  redraw
+  call assert_equal('Type', synIDattr(synID(5, 3, 1), 'name'))
+
+  " I with dot above and the Kelvin sign fold to "i" and "k"
+  if has('multi_byte') && &encoding == 'utf-8'
+    syn clear
+    syn case ignore
+    set re=2
+    call setline(1, ["foo\u0130", "ba\u212a"])
+    syn match Type /fooi/
+    syn match Type /fo\+i/
+    syn match Statement /bak/
+    redraw
+    call assert_equal('Type', synIDattr(synID(1, 1, 1), 'name'))
+    call assert_equal('Statement', synIDattr(synID(2, 1, 1), 'name'))
+    syn clear
+    syn case match
+    syn match Type /\cfooi/
+    redraw
+    call assert_equal('Type', synIDattr(synID(1, 1, 1), 'name'))
+    set re=0
+  endif
+  bwipe!
+endfunc
+
+func IdleParseCount()
+  let line = matchstr(execute('syntime report'), '[^\n]*IdleNum[^\n]*')
+  return line == '' ? 0 : str2nr(split(line)[1])
+endfunc
+
+func IdleParseHold()
+  let g:idle_hold_count = IdleParseCount()
+endfunc
+
+func IdleParseStop(timer)
+  let g:idle_stop_count = IdleParseCount()
+  call feedkeys("\<Esc>", 't')
+endfunc
+
+func Test_syn_parse_idle()
+  if !has('timers') || !has('profile')
+    return
+  endif
+  new
+  call setline(1, repeat(['x = 1'], 20000))
+  syn match IdleNum /\d\+/
+  syn sync fromstart
+  redraw
+  syntime on
+  syntime clear
+
+  " Parsing ahead starts after CursorHold was triggered, it must not delay it.
+  let g:idle_hold_count = -1
+  let g:idle_stop_count = -1
+  au CursorHoldI * call IdleParseHold()
+  set updatetime=20
+  call timer_start(500, 'IdleParseStop')
+  call feedkeys('a', 'x!')
+  call assert_inrange(0, 100, g:idle_hold_count)
+  call assert_inrange(200, 20000, g:idle_stop_count)
+
+  au! CursorHoldI
+  set updatetime&
+  syntime off
+  syntime clear
+  bwipe!
+endfunc
@@ -14,3 +14,59 @@ function! Test_WriteFile()
   call assert_equal("vimmers", l[4])
   call delete(f)
 endfunction
+
+func Test_read_converted()
+  if !has('multi_byte')
+    return
+  endif
+  let f = 'Xconverted'
+  let ascii = repeat('abcdefgh', 5)
+  " Latin1 text, mostly ASCII with a few non-ASCII characters.
+  call writefile([ascii, "caf\xe9 " . ascii, ascii . "\xe9"], f, 'b')
+  exe 'new ++enc=latin1 ' . f
+  call assert_equal([ascii, 'café ' . ascii, ascii . 'é'], getline(1, '$'))
+  bwipe!
+  " Valid and invalid UTF-8 after a long run of ASCII.
+  call writefile([ascii . 'é', ascii . "\xff" . ascii], f, 'b')
+  exe 'new ++enc=utf-8 ++bad=X ' . f
+  call assert_equal([ascii . 'é', ascii . 'X' . ascii], getline(1, '$'))
+  bwipe!
+  call delete(f)
+endfunc
+
+func Test_write_long_lines()
+  let f = 'Xwritelong'
+  new
+  " Lines longer than the write buffer, with NULs and CRs in them.
+  let long = repeat("ab\ncd\r", 100000)
+  call setline(1, [long, '', long . 'x'])
+  exe 'write ' . f
+  call assert_equal(len(long) * 2 + 4, getfsize(f))
+  exe 'edit! ' . f
+  call assert_equal([long, '', long . 'x'], getline(1, '$'))
+
+  set fileformat=mac
+  exe 'write! ' . f
+  bwipe!
+  exe 'edit ++ff=mac ' . f
+  call assert_equal([long, '', long . 'x'], getline(1, '$'))
+  bwipe!
+  call delete(f)
+endfunc
+
+func Test_write_verbose()
+  if !has('reltime')
+    return
+  endif
+  let f = 'Xwriteverbose'
+  new
+  call setline(1, ['one', 'two'])
+  set verbose=1
+  redir => msgs
+  exe 'write ' . f
+  redir END
+  set verbose&
+  call assert_match('Wrote 8 bytes to "' . f . '" in [0-9.]\+ seconds', msgs)
+  bwipe!
+  call delete(f)
+endfunc
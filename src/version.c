@@ -238,6 +238,11 @@ static char *(features[]) =
 #else
 	"-file_in_path",
 #endif
+#ifdef FEAT_FILEWATCH
+	"+filewatch",
+#else
+	"-filewatch",
+#endif
 #ifdef FEAT_FIND_ID
 	"+find_in_path",
 #else
@@ -584,6 +589,11 @@ static char *(features[]) =
 	"+syntax",
 #else
 	"-syntax",
+#endif
+#ifdef FEAT_SYN_CACHE
+	"+syntax_cache",
+#else
+	"-syntax_cache",
 #endif
 	    /* only interesting on Unix systems */
 #if defined(USE_SYSTEM) && defined(UNIX)
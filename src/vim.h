@@ -886,6 +886,7 @@ extern char *(*dyn_libintl_textdomain)(const char *domainname);
 # define SST_MAX_ENTRIES 1000	/* maximal size for state stack array */
 # define SST_FIX_STATES	 7	/* size of sst_stack[]. */
 # define SST_DIST	 16	/* normal distance between entries */
+# define SST_IDLE_MSEC	 20L	/* msec parsing ahead when idle, per call */
 # define SST_INVALID	(synstate_T *)-1	/* invalid syn_state pointer */
 
 # define HL_CONTAINED	0x01	/* not used on toplevel */
@@ -1844,6 +1845,17 @@ typedef int sock_T;
 #define PROF_YES	1	/* profiling busy */
 #define PROF_PAUSED	2	/* profiling paused */
 
+/* Items measured by ":redrawprofile". */
+#define RDP_REDRAW	0	/* one screen update */
+#define RDP_WIN_UPDATE	1	/* win_update() */
+#define RDP_WIN_LINE	2	/* win_line() */
+#define RDP_FOLD_LINE	3	/* fold_line() */
+#define RDP_SEARCH_HL	4	/* prepare_search_hl() */
+#define RDP_SYNTAX	5	/* get_syntax_attr() */
+#define RDP_SCREEN_LINE	6	/* screen_line() */
+#define RDP_OUT_FLUSH	7	/* out_flush() */
+#define RDP_COUNT	8	/* number of items */
+
 #ifdef FEAT_MOUSE
 
 /* Codes for mouse button events in lower three bits: */